@@ -2,16 +2,37 @@
 #define _h_libcmdline_cmdline
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <functional>
 #include <list>
+#include <memory>
+#include <algorithm>
+#include <iosfwd>
+#include <cstdio>
+
+#include "libcmdline/stats.h"
+#include "libcmdline/convert.h"
+#include "libcmdline/tokenizer.h"
+#include "libcmdline/constraints.h"
 
 namespace cmdline
 {
 	class Parser;
+	class SchemaBlob;
 	struct Argument;
 	struct Option;
 	struct Switch;
+	struct ParseEvent;
+	struct EventCursor;
+	struct UsageCounters;
+	class UsageRecorder;
+	class FileValue;
+
+	namespace detail
+	{
+		class HelpOutput;
+	}
 
 	constexpr char NoAbbr = 0; // Argument has no abbreviation
 
@@ -21,7 +42,8 @@ namespace cmdline
 	// Create argument enablement predicate that's always enabled
 	ArgumentEnablePred enableAlways();
 
-	// Create argument enablement predicate that's enabled when switch s is set
+	// Create argument enablement predicate that's enabled when switch s is set.
+	// Copies of the parser owning s evaluate it against their own copy of s.
 	ArgumentEnablePred enableWhenSwitchIsSet(const Switch& s);
 
 	// Parser help predicate used to generate help string for the command
@@ -30,12 +52,37 @@ namespace cmdline
 	// Create help predicate that returns given help text
 	HelpPred staticHelp(const std::string& help);
 
+	// Produces the description of an entry added without one. Only called
+	// when help is generated, so descriptions needn't stay in memory.
+	using DescriptionProvider = std::function<std::string(const Argument& arg)>;
+
+	// Called with an entry whose value was changed by Parser::reload
+	using ChangeCallback = std::function<void(const Argument& arg)>;
+
+	// Run as soon as the entry is parsed. Returning true stops parsing, the
+	// remaining tokens and validation are skipped, see ParseResult::stopped.
+	using ArgumentAction = std::function<bool(const Argument& arg)>;
+
 	enum class Req
 	{
 		required,
 		optional
 	};
 
+	enum class ArgKind : uint8_t
+	{
+		argument, // Positional argument
+		option,
+		switch_
+	};
+
+	enum class ParseStatus
+	{
+		ok,
+		failed,
+		stopped // An action ended parsing early, eg. --help
+	};
+
 	class ParseResult
 	{
 	public:
@@ -49,11 +96,26 @@ namespace cmdline
 
 		std::string errorStr() const;
 
+		// Stopped results are successful unless tokens before the action failed
+		ParseStatus status() const;
+		bool stopped() const;
+
+		// Name of the entry whose action stopped parsing
+		const std::string& stoppedBy() const;
+		void stop(const std::string& name);
+
+		// Keep a file given as an option value mapped for the lifetime of the
+		// result, see Option::allowFile
+		void keep(std::shared_ptr<const FileValue> file);
+
 	protected:
 		std::vector<std::string> errors;
+		bool isStopped = false;
+		std::string stopName;
+		std::vector<std::shared_ptr<const FileValue>> files;
 	};
 
-	class ArgumentParseResult : public ParseResult
+	class ArgumentParseResult final : public ParseResult
 	{
 	public:
 		ArgumentParseResult(bool accepted, const std::string& error = "");
@@ -82,6 +144,10 @@ namespace cmdline
 	// Any command line argument
 	struct Argument
 	{
+		// Set by the constructors, dispatch on it instead of casting so the
+		// library builds without RTTI
+		ArgKind kind = ArgKind::argument;
+
 		std::string name;
 		std::string value = "";
 		Req required;
@@ -91,6 +157,14 @@ namespace cmdline
 		HelpSection* helpSection = nullptr;
 		size_t helpIndex = 0;
 
+		// When set, parsed values are converted into the bound variable instead of value
+		Binding binding = {};
+
+		ArgumentAction action = {};
+
+		// Checked against every parsed value, shared between copies
+		std::shared_ptr<const ValueConstraints> constraints;
+
 		Argument(
 				const std::string& name, 
 				const std::string& value = "", 
@@ -107,9 +181,10 @@ namespace cmdline
 
 		virtual ~Argument() = default;
 
-		virtual bool expectsValue() const
+		// Only options take a value, switches are on or off
+		bool expectsValue() const
 		{
-			return false;
+			return this->kind == ArgKind::option;
 		}
 
 		bool enabled() const
@@ -147,16 +222,115 @@ namespace cmdline
 			return *this;
 		}
 
+		Argument& setAction(ArgumentAction action)
+		{
+			this->action = action;
+			return *this;
+		}
+
+		Argument& setRange(double min, double max)
+		{
+			this->editConstraints().setRange(min, max);
+			return *this;
+		}
+
+		Argument& setChoices(const std::vector<std::string>& choices)
+		{
+			this->editConstraints().setChoices(choices);
+			return *this;
+		}
+
+		Argument& setPattern(const std::string& pattern)
+		{
+			this->editConstraints().setPattern(pattern);
+			return *this;
+		}
+
+		template <typename T>
+		Argument& bindTo(T& target)
+		{
+			this->binding = bind(target);
+			return *this;
+		}
+
+		// True when the argument holds a value, either as a string or in its bound variable
+		bool hasValue() const
+		{
+			return this->binding ? this->binding.assigned : !this->value.empty();
+		}
+
 		operator bool() const
 		{
-			return !this->value.empty();
+			return this->hasValue();
+		}
+
+	private:
+		ValueConstraints& editConstraints()
+		{
+			auto c = this->constraints ? std::make_shared<ValueConstraints>(*this->constraints) : std::make_shared<ValueConstraints>();
+			this->constraints = c;
+			return *c;
+		}
+	};
+
+	// Read-only view of consecutive values, eg. the values of a variadic
+	// argument. The values point into the parsed tokens.
+	class ValueSpan
+	{
+	public:
+		ValueSpan() = default;
+		ValueSpan(const std::string_view* data, size_t size)
+			: first(data)
+			, count(size)
+		{ }
+
+		const std::string_view* begin() const
+		{
+			return this->first;
+		}
+
+		const std::string_view* end() const
+		{
+			return this->first + this->count;
+		}
+
+		const std::string_view& operator[](size_t i) const
+		{
+			return this->first[i];
+		}
+
+		size_t size() const
+		{
+			return this->count;
+		}
+
+		bool empty() const
+		{
+			return this->count == 0;
 		}
+
+	protected:
+		const std::string_view* first = nullptr;
+		size_t count = 0;
 	};
 
 	// Arguments prefixed with hyphens
 	struct Option : Argument
 	{
 		char abbr = NoAbbr;
+		size_t id = 0; // Index in the parser presence bitset, assigned by the parser
+
+		// Other spellings of the option, eg. kept for backwards compatibility.
+		// Aliases of an option already added to a parser go through
+		// Parser::addAlias, so that its lookup index knows them.
+		std::vector<std::string> aliases;
+		std::string abbrAliases;
+
+		// File capable options take --name=@path, the value stays "@path" and
+		// the file is mapped when contents is first called. @@ escapes a
+		// leading @. Bound or constrained options read the file while parsing.
+		bool fileCapable = false;
+		std::shared_ptr<const FileValue> file; // Set when given as @path
 
 		Option(
 				const std::string& name, 
@@ -168,17 +342,98 @@ namespace cmdline
 		)
 			: Argument(name, value, required, description, enablePred)
 			, abbr(abbr)
-		{ }
-		
-		virtual bool expectsValue() const
 		{
-			return true;
+			this->kind = ArgKind::option;
 		}
+
+		Option& allowFile(bool allow = true)
+		{
+			this->fileCapable = allow;
+			return *this;
+		}
+
+		// The value, or the contents of the file it names
+		std::string_view contents() const;
 	};
 
-	// Options that may have no value (either on or off)
+	// Dense state of options and switches indexed by Option::id, owned by the parser
+	class ArgumentStates
+	{
+	public:
+		void resize(size_t count)
+		{
+			this->onBits.resize((count + 63) / 64, 0);
+			this->givenBits.resize((count + 63) / 64, 0);
+		}
+
+		bool on(size_t id) const
+		{
+			return test(this->onBits, id);
+		}
+
+		// True if given on the command line in the last parse
+		bool given(size_t id) const
+		{
+			return test(this->givenBits, id);
+		}
+
+		void setOn(size_t id, bool value)
+		{
+			uint64_t bit = uint64_t(1) << (id % 64);
+			if (value)
+				this->onBits[id / 64] |= bit;
+			else
+				this->onBits[id / 64] &= ~bit;
+		}
+
+		void setGiven(size_t id)
+		{
+			this->givenBits[id / 64] |= uint64_t(1) << (id % 64);
+		}
+
+		void clearGiven()
+		{
+			std::fill(this->givenBits.begin(), this->givenBits.end(), 0);
+		}
+
+		// Shared by copies of the states, used by enableWhenSwitchIsSet to
+		// find the same switch in copied parsers
+		uint64_t getOrigin() const
+		{
+			return this->origin;
+		}
+
+		// Whole bitsets, eg. to compare many switches at once
+		const std::vector<uint64_t>& getOn() const
+		{
+			return this->onBits;
+		}
+
+		const std::vector<uint64_t>& getGiven() const
+		{
+			return this->givenBits;
+		}
+
+	private:
+		static bool test(const std::vector<uint64_t>& bits, size_t id)
+		{
+			return id / 64 < bits.size() && (bits[id / 64] >> (id % 64)) & 1;
+		}
+
+		static uint64_t nextOrigin();
+
+		std::vector<uint64_t> onBits;
+		std::vector<uint64_t> givenBits;
+		uint64_t origin = nextOrigin();
+	};
+
+	// Options that may have no value (either on or off).
+	// State of switches added to a parser is kept in the parser ArgumentStates,
+	// standalone switches use the value string.
 	struct Switch : Option
 	{
+		ArgumentStates* states = nullptr;
+
 		Switch(
 				const std::string& name, 
 				char abbr = NoAbbr, 
@@ -186,36 +441,143 @@ namespace cmdline
 				ArgumentEnablePred enablePred = enableAlways()
 		)
 			: Option(name, abbr, "", Req::optional, description, enablePred)
-		{ }
-
-		virtual bool expectsValue() const
 		{
-			return false;
+			this->kind = ArgKind::switch_;
 		}
 
 		void setValue(bool value)
 		{
-			this->value = value ? "1" : "";
+			if (this->states)
+				this->states->setOn(this->id, value);
+			else
+				this->value = value ? "1" : "";
+
+			if (this->binding)
+				this->binding.assigned = this->binding.assign(this->binding.target, value ? "1" : "0");
 		}
 
 		bool on() const
 		{
-			return !this->value.empty();
+			return this->states ? this->states->on(this->id) : !this->value.empty();
+		}
+
+		// True if given on the command line in the last parse
+		bool given() const
+		{
+			return this->states && this->states->given(this->id);
+		}
+
+		operator bool() const
+		{
+			return this->on();
 		}
 	};
 
 
+	// Lookup data of options and switches stored contiguously, apart from the
+	// entries themselves, so that resolving a name or abbreviation only
+	// touches hashes and kinds until a candidate entry is found. Entries with
+	// help-only data (descriptions, sections) stay in the parser lists.
+	class LookupIndex
+	{
+	public:
+		void clear();
+
+		// Add the entry under its name, abbreviation and aliases
+		void add(Option& entry, ArgKind kind);
+
+		// Add a single spelling, false if it's taken. Name index 0 is the entry
+		// name, i is its alias i - 1.
+		bool addName(Option& entry, ArgKind kind, size_t nameIndex);
+		bool addAbbr(Option& entry, ArgKind kind, char abbr);
+
+		Option* find(std::string_view name, ArgKind kind) const;
+		Option* find(char abbr, ArgKind kind) const;
+
+	protected:
+		void rehash(size_t slotCount);
+
+	protected:
+		// One record per name, indexed by record number
+		std::vector<uint32_t> hashes;
+		std::vector<ArgKind> kinds;
+		std::vector<Option*> entries;
+		std::vector<uint32_t> names;
+
+		std::vector<uint32_t> slots; // Open addressing, record number + 1
+
+		// Entry per abbreviation, options followed by switches
+		std::vector<Option*> abbrs = std::vector<Option*>(512, nullptr);
+	};
+
+	// Raw values known to Parser::reload, arguments by position and options
+	// and switches by id. Switches are "1" when on.
+	struct ReloadValues
+	{
+		std::vector<std::string> arguments;
+		std::vector<std::string> options;
+	};
+
+	// Constraint between options and switches given on the command line
+	struct OptionGroup
+	{
+		enum class Kind
+		{
+			exclusive,  // At most one given, exactly one if required
+			atLeastOne,
+			allOrNone,
+			dependency  // Trigger requires all the options in the mask
+		};
+
+		Kind kind;
+		Req required = Req::optional;
+		std::vector<std::string> names;
+		std::vector<std::string> unknown; // Names not found when the group was added
+
+		// Bitsets indexed by Option::id
+		std::vector<uint64_t> mask;
+		std::vector<uint64_t> trigger;
+	};
+
 	class Parser
 	{
 	public:
 		// autohelp - when true, will add standard --help and -? switches for displaying help message. Later user can use Parser::helpRequested and Parser::getHelp functions to display the help string
 		Parser(bool autohelp = true);
 
+		// Copies own their switch states
+		Parser(const Parser& b);
+		Parser(Parser&& b) = default;
+		Parser& operator=(const Parser& b);
+		Parser& operator=(Parser&& b) = default;
+
+		// Parser sharing the entries of base, which must not change anymore.
+		// Entries are copied only when first looked up, so creating many
+		// parsers from one base (eg. per tenant) costs only what each uses.
+		// Entries added to this parser don't affect the base.
+		explicit Parser(std::shared_ptr<const Parser> base);
+
 		// Parse given arguments. Keep in mind the first argument
 		// must be the name of the application.
 		ParseResult parse(int argc, char** argv);
 		ParseResult parse(const std::vector<std::string>& args);
 
+		// Parse a single line split with shell quoting rules, eg. a command
+		// typed into an interactive shell. Unlike parse, every token is an
+		// argument, the line doesn't start with the application name.
+		// Tokenizer buffers are reused, so steady state parsing doesn't allocate.
+		ParseResult parseLine(std::string_view line);
+
+		// Parse a NUL separated command line as found in /proc/<pid>/cmdline,
+		// starting with the command name. Tokens are views into buffer. See
+		// CmdlineScanner in reader.h for parsing many of them.
+		ParseResult parseBuffer(std::string_view buffer);
+
+		// Read one event from token without changing the parser, next is the
+		// following token if there's one. Returns the number of tokens consumed,
+		// 0 while clustered switches (-xyz) remain. See EventStream in events.h.
+		size_t readEvent(std::string_view token, const std::string_view* next, EventCursor& cursor, ParseEvent& event) const;
+
 		Argument& addArgument(
 				const std::string& name, 
 				const std::string& value = "", 
@@ -224,6 +586,29 @@ namespace cmdline
 				ArgumentEnablePred dependsOn = enableAlways());
 		Argument& addArgument(const Argument& arg);
 
+		// Bind argument to a typed variable, see ValueConverter for supported types.
+		// Strings are bound with Argument::bindTo, a string here is the default value.
+		template <typename T, typename = std::enable_if_t<!std::is_convertible_v<T&, std::string>>>
+		Argument& addArgument(
+				const std::string& name, 
+				T& target,
+				Req required = Req::required,
+				const std::string& description = "",
+				ArgumentEnablePred dependsOn = enableAlways())
+		{
+			return this->addArgument(name, "", required, description, dependsOn).bindTo(target);
+		}
+
+		// Trailing positional argument taking between min and max values, no
+		// upper limit when max is 0. It must be the last positional argument.
+		// Values are kept as views of the parsed tokens, see getVariadic, and
+		// converted one by one when bound (eg. to a std::vector).
+		Argument& addVariadic(
+				const std::string& name, 
+				size_t min = 0, 
+				size_t max = 0,
+				const std::string& description = "");
+
 		Option& addOption(
 				const std::string& name, 
 				char abbr = NoAbbr, 
@@ -233,6 +618,22 @@ namespace cmdline
 				ArgumentEnablePred dependsOn = enableAlways());
 		Option& addOption(const Option& option);
 
+		// Bind option to a typed variable, see ValueConverter for supported types.
+		// Strings are bound with Argument::bindTo, a string here is the default value.
+		template <typename T, typename = std::enable_if_t<!std::is_convertible_v<T&, std::string>>>
+		Option& addOption(
+				const std::string& name, 
+				char abbr,
+				T& target,
+				Req required = Req::optional,
+				const std::string& description = "",
+				ArgumentEnablePred dependsOn = enableAlways())
+		{
+			Option& opt = this->addOption(name, abbr, "", required, description, dependsOn);
+			opt.bindTo(target);
+			return opt;
+		}
+
 		Switch& addSwitch(
 				const std::string& name, 
 				char abbr = NoAbbr,
@@ -240,19 +641,78 @@ namespace cmdline
 				ArgumentEnablePred dependsOn = enableAlways());
 		Switch& addSwitch(const Switch& sw);
 
+		// Bind switch to a bool variable set to true when the switch is given
+		Switch& addSwitch(
+				const std::string& name, 
+				char abbr,
+				bool& target,
+				const std::string& description = "",
+				ArgumentEnablePred dependsOn = enableAlways());
+
+		// Options and switches given by name, validated after every parse.
+		// Groups are checked with a few word operations on the presence bitset.
+		void addExclusiveGroup(const std::vector<std::string>& names, Req required = Req::optional);
+		void addAtLeastOneGroup(const std::vector<std::string>& names);
+		void addAllOrNoneGroup(const std::vector<std::string>& names);
+		void addRequirement(const std::string& name, const std::vector<std::string>& required);
+
+		// Make another name or abbreviation resolve to an option or switch.
+		// False if there's no such entry or the alias is already taken.
+		bool addAlias(std::string_view name, const std::string& alias);
+		bool addAlias(std::string_view name, char abbr);
+
+		// Count how often every option and switch is given, left at its default
+		// or rejected, and which unknown options are used. Entries of a schema
+		// blob are counted once they're looked up. Costs a single branch per
+		// event while no recorder is set.
+		void setUsageRecorder(std::shared_ptr<UsageRecorder> recorder);
+
+		// Parse a complete new command line, eg. after a configuration file
+		// changed, and apply only the entries whose value differs from the
+		// previous reload. Entries missing from the command line go back to the
+		// values they had before the first reload. Nothing is applied if
+		// parsing fails.
+		ParseResult reload(int argc, char** argv);
+		ParseResult reload(const std::vector<std::string>& args);
+
+		// Call back after a reload changed the entry with the given name
+		void onChange(const std::string& name, ChangeCallback callback);
+
+		// Raw values of all entries, and putting them back, eg. to reset the
+		// parser between command lines. Bound variables keep their values,
+		// the bindings are only marked as unassigned.
+		ReloadValues currentValues() const;
+		void restoreValues(const ReloadValues& values);
+
+		// True if the option or switch was given in the last parse
+		bool isGiven(const Option& opt) const;
+
+		// Add the flags declared anywhere in the program (see registry.h) on
+		// the first lookup or parse
+		void useRegistry();
+
+		// The standard --help and --version switches stop parsing when given
 		void addStandardHelpSwitch();
+		void addStandardVersionSwitch(const std::string& version);
 		void addHelpSection(const HelpSection& hs);
 		void addHelpSection(const std::string& name, const std::string& description = "");
 
-		Argument* getArgument(const std::string& name);
+		Argument* getArgument(std::string_view name);
 		Argument* getArgument(size_t pos);
-		const Argument* getArgument(const std::string& name) const;
-		Option* getOption(const std::string& name);
+		const Argument* getArgument(std::string_view name) const;
+		Option* getOption(std::string_view name);
 		Option* getOption(const char abbr);
-		const Option* getOption(const std::string& name) const;
-		Switch* getSwitch(const std::string& name);
+		const Option* getOption(std::string_view name) const;
+		const Option* getOption(const char abbr) const;
+		Switch* getSwitch(std::string_view name);
 		Switch* getSwitch(const char abbr);
-		const Switch* getSwitch(const std::string& name) const;
+		const Switch* getSwitch(std::string_view name) const;
+		const Switch* getSwitch(const char abbr) const;
+
+		// Values given to the variadic argument in the last parse. They point
+		// into argv, the vector passed to parse or the tokens of parseLine, and
+		// are valid as long as those are.
+		ValueSpan getVariadic() const;
 
 		std::vector<std::reference_wrapper<const Argument>> getArguments() const;
 		std::vector<std::reference_wrapper<const Option>> getOptions() const;
@@ -260,19 +720,50 @@ namespace cmdline
 
 		bool helpRequested() const
 		{
+			if (this->helpId != NoId)
+				return this->states->on(this->helpId);
+
 			const auto* sw = this->getSwitch("help");
 			return sw && sw->on();
 		}
 
+		bool versionRequested() const
+		{
+			if (this->versionId != NoId)
+				return this->states->on(this->versionId);
+			return false;
+		}
+
+		const std::string& getVersion() const
+		{
+			return this->version;
+		}
+
+		// State of all options and switches, copy it for a snapshot
+		const ArgumentStates& getStates() const;
+
 		ArgumentParseResult validateArguments() const;
 		ArgumentParseResult validateOptions() const;
+		ArgumentParseResult validateGroups() const;
 
 		// Check if command isn't ill-formed before parse is called.
 		// Eg. optional positional arguments must be at the end of the command line
 		ParseResult validateCommand() const;
 
-		static bool isOption(const std::string& arg);
-		static bool isOptionAbbr(const std::string& arg);
+		// Validate the complete schema once: the checks of validateCommand,
+		// names and abbreviations defined more than once or by both an option
+		// and a switch, and predicates reading switches of other parsers. All
+		// schema blob entries are created. Parses of a frozen parser skip the
+		// schema checks, adding entries unfreezes it.
+		ParseResult freeze();
+
+		bool isFrozen() const
+		{
+			return this->frozen;
+		}
+
+		static bool isOption(std::string_view arg);
+		static bool isOptionAbbr(std::string_view arg);
 
 		static std::string getOptionName(const std::string& arg);
 		static std::string getOptionAbbr(const std::string& arg);
@@ -282,6 +773,8 @@ namespace cmdline
 
 		// Get argument representation in '--arg, -a [value]' format
 		static std::string getArgRepresentation(const Argument& arg);
+		// Get argument description followed by the accepted choices, if any
+		static std::string getArgDescription(const Argument& arg);
 		size_t getNameLength(const std::vector<std::reference_wrapper<const Argument>>& args) const;
 
 		void setHelpMaxWidth(size_t w);
@@ -289,24 +782,140 @@ namespace cmdline
 		void setHelp(const std::string& help);
 		std::string getHelp() const;
 
+		// Supply descriptions on demand, eg. decoded from a compressed table
+		void setDescriptionProvider(DescriptionProvider provider);
+
+		// Description of an entry: its own, the provider's or the schema blob's
+		std::string getDescription(const Argument& arg) const;
+
+		// Write the same text as getHelp through a fixed size buffer, without
+		// building it in memory first. False if writing failed.
+		bool writeHelp(std::ostream& out) const;
+		bool writeHelp(std::FILE* out) const;
+		bool writeHelp(int fd) const;
+
+		// Serialize the schema (entries, defaults, descriptions, help sections
+		// and help text) into a blob that can be loaded with SchemaBlob
+		std::string saveSchema() const;
+
+		// Use a schema blob instead of adding entries one by one. Options and
+		// switches are created from the blob only when first looked up, so
+		// attaching even large schemas is nearly free.
+		void setSchema(std::shared_ptr<const SchemaBlob> schema);
+
+		// Per-phase timings and counters. Only recorded when the library is
+		// built with LIBCMDLINE_INSTRUMENTATION, otherwise always empty.
+		const ParserStats& getStats() const;
+		void resetStats();
+
 	protected:
-		ArgumentParseResult parseArgument(const std::string& arg, size_t& pos);
-		ArgumentParseResult parseOption(const std::string& arg, Option** activeOption);	
-		ArgumentParseResult parseSwitch(const std::string& arg);
+		// Parse tokens following the application name
+		template <typename It>
+		ParseResult parseTokens(It begin, It end);
+
+		ArgumentParseResult parseArgument(std::string_view arg, size_t& pos);
+		ArgumentParseResult parseOption(std::string_view arg, Option** activeOption);	
+		ArgumentParseResult parseSwitch(std::string_view arg);
+
+		// Store value in the argument or convert it into its bound variable
+		ArgumentParseResult checkValue(const Argument& arg, std::string_view value) const;
+		ArgumentParseResult assignValue(Argument& arg, std::string_view value);
+		ArgumentParseResult assignValue(Option& opt, std::string_view value);
+		ArgumentParseResult assignFile(Option& opt, std::string_view value);
+
+		void recordRejected(const Option& opt) const;
+		void recordUsage() const;
+
+		bool isEnabled(const Argument& arg) const;
+
+		size_t schemaFind(std::string_view name, ArgKind kind) const;
+		size_t schemaFind(char abbr, ArgKind kind) const;
+		Argument* materialize(size_t i) const;
+
+		Option* lookup(std::string_view name, ArgKind kind) const;
+		Option* lookup(char abbr, ArgKind kind) const;
+		Option* inherit(const Option* entry, ArgKind kind) const;
+		void inheritAll() const;
+		void rebindSection(Argument& arg, const Parser& from) const;
+		void materializeAll() const;
+		void loadRegistry() const;
+		bool schemaRequiresMissing(std::string& name) const;
+
+		// Assign id to an option or switch added to the lists
+		void attach(Option& opt) const;
+		void attach(Switch& sw) const;
+		void markGiven(const Option& opt);
+		void runAction(const Argument& arg);
+		OptionGroup& addGroup(OptionGroup::Kind kind, const std::vector<std::string>& names);
+
+		// Help text generation shared by getHelp and writeHelp
+		void writeHelp(detail::HelpOutput& out) const;
 
 	protected:
+		static constexpr size_t NoId = static_cast<size_t>(-1);
+
 		std::string cmdname;
-		std::list<Argument> args;
-		std::list<Option> options;
-		std::list<Switch> switches;
+		// Mutable, as entries of the schema blob are added on lookup
+		mutable std::list<Argument> args;
+		mutable std::list<Option> options;
+		mutable std::list<Switch> switches;
+
+		// Hot lookup data, rebuilt when the parser is copied
+		mutable LookupIndex index;
+		mutable std::vector<Argument*> positional;
+
+		size_t variadicPos = NoId; // Index into positional
+		size_t variadicMin = 0;
+		size_t variadicMax = 0;
+		std::vector<std::string_view> variadicValues;
+
+		bool frozen = false;
+		mutable bool registryPending = false;
+
+		// Shared parser whose entries are copied on lookup
+		std::shared_ptr<const Parser> base;
+		mutable std::vector<bool> inherited; // By base option id
+		std::vector<const Option*> baseRequired;
+
+		std::shared_ptr<const SchemaBlob> schema;
+		mutable std::vector<bool> materialized;
+		size_t schemaSectionBase = 0;
 
 		std::vector<HelpSection> helpSections;
 
+		std::vector<OptionGroup> groups;
+		mutable size_t optionCount = 0; // Ids assigned so far
+		std::unique_ptr<ArgumentStates> states = std::make_unique<ArgumentStates>();
+
+		size_t helpId = NoId;
+		size_t versionId = NoId;
+		std::string version;
+
+		// Entry whose action stopped the parse in progress
+		const Argument* stopper = nullptr;
+
 		bool autohelp;
 		size_t helpMaxWidth = 250;
 		size_t helpMaxArgWidth = 50;
 
-		HelpPred helpPred = {};		
+		HelpPred helpPred = {};
+		DescriptionProvider descriptionProvider = {};
+
+		std::shared_ptr<UsageRecorder> usage;
+		mutable std::vector<UsageCounters*> usageSlots; // By option id
+
+		bool reloaded = false;
+		ReloadValues reloadDefaults;
+		ReloadValues reloadApplied;
+		std::vector<std::pair<std::string, ChangeCallback>> changeCallbacks;		
+
+		LineTokenizer tokenizer;
+
+		mutable ParserStats stats;
+#ifdef LIBCMDLINE_INSTRUMENTATION
+		mutable unsigned activePhases = 0;
+		std::chrono::steady_clock::time_point statsEpoch = std::chrono::steady_clock::now();
+#endif
 	};
 }
 
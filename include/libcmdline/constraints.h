@@ -0,0 +1,44 @@
+#ifndef _h_libcmdline_constraints
+#define _h_libcmdline_constraints
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_set>
+#include <regex>
+#include <optional>
+
+namespace cmdline
+{
+	// Restrictions on values accepted by an argument, checked while parsing.
+	// Built once when the schema is defined and shared between copies.
+	class ValueConstraints
+	{
+	public:
+		// Value must be a number within [min, max]
+		void setRange(double min, double max);
+
+		// Value must be one of the given strings
+		void setChoices(const std::vector<std::string>& choices);
+
+		// Whole value must match the ECMAScript regular expression.
+		// Throws std::regex_error if the pattern is malformed.
+		void setPattern(const std::string& pattern);
+
+		// Empty if value satisfies all constraints, otherwise the reason it doesn't
+		std::string check(std::string_view value) const;
+
+		const std::vector<std::string>& getChoices() const;
+
+	protected:
+		std::optional<std::pair<double, double>> range;
+
+		std::vector<std::string> choices;
+		std::unordered_set<std::string_view> choiceIndex; // Views into choices
+
+		std::string patternSource;
+		std::optional<std::regex> pattern;
+	};
+}
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef _h_libcmdline_convert
+#define _h_libcmdline_convert
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <charconv>
+#include <type_traits>
+
+namespace cmdline
+{
+	// Converts command line strings into typed values. Specialize for custom
+	// types (eg. enums with named values) to make them bindable.
+	template <typename T, typename Enable = void>
+	struct ValueConverter;
+
+	template <>
+	struct ValueConverter<std::string>
+	{
+		static bool convert(std::string_view str, std::string& out)
+		{
+			out.assign(str.data(), str.size());
+			return true;
+		}
+	};
+
+	template <>
+	struct ValueConverter<bool>
+	{
+		static bool convert(std::string_view str, bool& out)
+		{
+			if (str == "1" || str == "true" || str == "yes" || str == "on")
+				out = true;
+			else if (str == "0" || str == "false" || str == "no" || str == "off")
+				out = false;
+			else
+				return false;
+			return true;
+		}
+	};
+
+	template <typename T>
+	struct ValueConverter<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+	{
+		static bool convert(std::string_view str, T& out)
+		{
+			const char* end = str.data() + str.size();
+			auto res = std::from_chars(str.data(), end, out);
+			return res.ec == std::errc() && res.ptr == end;
+		}
+	};
+
+	template <typename T>
+	struct ValueConverter<T, std::enable_if_t<std::is_floating_point_v<T>>>
+	{
+		static bool convert(std::string_view str, T& out)
+		{
+			const char* end = str.data() + str.size();
+			auto res = std::from_chars(str.data(), end, out);
+			return res.ec == std::errc() && res.ptr == end;
+		}
+	};
+
+	// Enums are given by their underlying value unless specialized
+	template <typename T>
+	struct ValueConverter<T, std::enable_if_t<std::is_enum_v<T>>>
+	{
+		static bool convert(std::string_view str, T& out)
+		{
+			std::underlying_type_t<T> val;
+			if (!ValueConverter<std::underlying_type_t<T>>::convert(str, val))
+				return false;
+			out = static_cast<T>(val);
+			return true;
+		}
+	};
+
+	// Durations accept an optional unit suffix (ns, us, ms, s, min, h), eg. 250ms.
+	// Values without a suffix are in the units of the destination.
+	template <typename Rep, typename Period>
+	struct ValueConverter<std::chrono::duration<Rep, Period>>
+	{
+		static bool convert(std::string_view str, std::chrono::duration<Rep, Period>& out)
+		{
+			size_t split = str.find_first_not_of("0123456789-");
+			std::string_view num = str.substr(0, split);
+			std::string_view unit = split == std::string_view::npos ? std::string_view() : str.substr(split);
+
+			long long count;
+			if (!ValueConverter<long long>::convert(num, count))
+				return false;
+
+			using namespace std::chrono;
+			using Target = duration<Rep, Period>;
+			if (unit.empty())
+				out = Target(static_cast<Rep>(count));
+			else if (unit == "ns")
+				out = duration_cast<Target>(nanoseconds(count));
+			else if (unit == "us")
+				out = duration_cast<Target>(microseconds(count));
+			else if (unit == "ms")
+				out = duration_cast<Target>(milliseconds(count));
+			else if (unit == "s")
+				out = duration_cast<Target>(seconds(count));
+			else if (unit == "min")
+				out = duration_cast<Target>(minutes(count));
+			else if (unit == "h")
+				out = duration_cast<Target>(hours(count));
+			else
+				return false;
+			return true;
+		}
+	};
+
+	// Every occurrence of the argument appends a value
+	template <typename T>
+	struct ValueConverter<std::vector<T>>
+	{
+		static bool convert(std::string_view str, std::vector<T>& out)
+		{
+			T val {};
+			if (!ValueConverter<T>::convert(str, val))
+				return false;
+			out.push_back(std::move(val));
+			return true;
+		}
+	};
+
+	// Typed destination for argument values. Plain function pointer and target
+	// address so that binding never allocates.
+	struct Binding
+	{
+		void* target = nullptr;
+		bool (*assign)(void* target, std::string_view value) = nullptr;
+		bool assigned = false; // Set once parsing wrote into the target
+
+		explicit operator bool() const
+		{
+			return this->assign != nullptr;
+		}
+	};
+
+	// Create binding writing converted values into target
+	template <typename T>
+	Binding bind(T& target)
+	{
+		Binding b;
+		b.target = &target;
+		b.assign = [](void* t, std::string_view value) {
+			return ValueConverter<T>::convert(value, *static_cast<T*>(t));
+		};
+		return b;
+	}
+}
+
+#endif
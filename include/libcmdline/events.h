@@ -0,0 +1,137 @@
+#ifndef _h_libcmdline_events
+#define _h_libcmdline_events
+
+#include "libcmdline/cmdline.h"
+
+#include <iterator>
+#include <string_view>
+
+namespace cmdline
+{
+	enum class EventKind
+	{
+		positional,
+		option,
+		switch_,
+		unknown,    // Option or switch not in the schema
+		terminator  // "--", every following token is positional
+	};
+
+	struct ParseEvent
+	{
+		EventKind kind = EventKind::unknown;
+		std::string_view token; // Token the event was read from
+		std::string_view name;  // Option or switch name as given, eg. "level" or "l"
+		std::string_view value; // Positional or option value
+		const Argument* entry = nullptr; // Matching schema entry, if any
+		size_t position = 0;    // Index of a positional argument
+		bool on = true;         // False for --no-xyz switches
+		bool missingValue = false; // Option given last without a value
+	};
+
+	// Position within the token sequence, kept between Parser::readEvent calls
+	struct EventCursor
+	{
+		size_t position = 0;
+		size_t offset = 0; // Next switch in a -xyz cluster
+		bool terminated = false;
+	};
+
+	// Single pass sequence of events read lazily from tokens convertible to
+	// std::string_view. Nothing is copied or written into the parser, and
+	// predicates and validation aren't applied, so callers can stop at any
+	// event and hand the tokens from remaining() on to someone else:
+	//
+	//   auto stream = cmdline::events(parser, argc, argv);
+	//   for (const auto& ev : stream)
+	//       if (ev.kind == cmdline::EventKind::positional)
+	//           break;
+	//   forward(stream.remaining(), argv + argc);
+	template <typename It>
+	class EventStream
+	{
+	public:
+		class iterator
+		{
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = ParseEvent;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const ParseEvent*;
+			using reference = const ParseEvent&;
+
+			iterator() = default;
+			explicit iterator(EventStream* stream) : stream(stream) {}
+
+			reference operator*() const { return this->stream->event; }
+			pointer operator->() const { return &this->stream->event; }
+
+			iterator& operator++()
+			{
+				if (!this->stream->advance())
+					this->stream = nullptr;
+				return *this;
+			}
+
+			bool operator==(const iterator& b) const { return this->stream == b.stream; }
+			bool operator!=(const iterator& b) const { return this->stream != b.stream; }
+
+		private:
+			EventStream* stream = nullptr;
+		};
+
+		EventStream(const Parser& parser, It begin, It end)
+			: parser(&parser)
+			, current(begin)
+			, last(end)
+		{
+		}
+
+		iterator begin() { return this->advance() ? iterator(this) : iterator(); }
+		iterator end() { return iterator(); }
+
+		// First token not consumed by the events read so far. A -xyz token
+		// counts as consumed once its last switch was read.
+		It remaining() const { return this->current; }
+
+		// Read the next event, false at the end of the tokens
+		bool advance()
+		{
+			if (this->current == this->last)
+				return false;
+
+			std::string_view token = *this->current;
+			It following = std::next(this->current);
+			std::string_view next;
+			if (following != this->last)
+				next = *following;
+
+			size_t consumed = this->parser->readEvent(token, following != this->last ? &next : nullptr, this->cursor, this->event);
+			std::advance(this->current, consumed);
+			return true;
+		}
+
+		const ParseEvent& get() const { return this->event; }
+
+	private:
+		const Parser* parser;
+		It current;
+		It last;
+		EventCursor cursor;
+		ParseEvent event;
+	};
+
+	template <typename It>
+	EventStream<It> events(const Parser& parser, It begin, It end)
+	{
+		return EventStream<It>(parser, begin, end);
+	}
+
+	// Events of main() arguments, the application name is skipped
+	inline EventStream<char**> events(const Parser& parser, int argc, char** argv)
+	{
+		return EventStream<char**>(parser, argv + std::min(argc, 1), argv + argc);
+	}
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef _h_libcmdline_fields
+#define _h_libcmdline_fields
+
+#include "libcmdline/cmdline.h"
+
+#include <tuple>
+#include <type_traits>
+
+namespace cmdline
+{
+	// Compile-time description of a struct member exposed on the command line.
+	// Describe a struct once and let addFields build the schema from it:
+	//
+	//   constexpr auto configFields = cmdline::fields(
+	//       cmdline::field(&Config::threads, "threads", 'j', "Worker threads"),
+	//       cmdline::field(&Config::verbose, "verbose", 'v', "Verbose output"),
+	//       cmdline::positional(&Config::input, "input", "Input file"));
+	//
+	//   cmdline::addFields(parser, config, configFields);
+	template <typename S, typename T>
+	struct Field
+	{
+		T S::* member;
+		const char* name;
+		char abbr = NoAbbr;
+		const char* description = "";
+		Req required = Req::optional;
+		bool positional = false;
+	};
+
+	// Option bound to a member, bool members become switches
+	template <typename S, typename T>
+	constexpr Field<S, T> field(T S::* member, const char* name, char abbr = NoAbbr, const char* description = "", Req required = Req::optional)
+	{
+		return { member, name, abbr, description, required, false };
+	}
+
+	// Positional argument bound to a member
+	template <typename S, typename T>
+	constexpr Field<S, T> positional(T S::* member, const char* name, const char* description = "", Req required = Req::required)
+	{
+		return { member, name, NoAbbr, description, required, true };
+	}
+
+	template <typename... F>
+	constexpr std::tuple<F...> fields(F... f)
+	{
+		return { f... };
+	}
+
+	template <typename S, typename T>
+	Argument& addField(Parser& parser, S& target, const Field<S, T>& f)
+	{
+		T& member = target.*(f.member);
+
+		if (f.positional)
+			return parser.addArgument(f.name, "", f.required, f.description).bindTo(member);
+
+		if constexpr (std::is_same_v<T, bool>)
+			return parser.addSwitch(f.name, f.abbr, member, f.description);
+		else
+			return parser.addOption(f.name, f.abbr, "", f.required, f.description).bindTo(member);
+	}
+
+	// Add every described member of target to the parser. Parsed values are
+	// converted straight into the members.
+	template <typename S, typename... T>
+	void addFields(Parser& parser, S& target, const std::tuple<Field<S, T>...>& f)
+	{
+		std::apply([&parser, &target](const auto&... field) {
+			(addField(parser, target, field), ...);
+		}, f);
+	}
+}
+
+#endif
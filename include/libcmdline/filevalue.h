@@ -0,0 +1,44 @@
+#ifndef _h_libcmdline_filevalue
+#define _h_libcmdline_filevalue
+
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace cmdline
+{
+	// File named by an option value given as @path, see Option::allowFile.
+	// The file is mapped read-only when its contents are first asked for.
+	class FileValue
+	{
+	public:
+		explicit FileValue(const std::string& path);
+		~FileValue();
+
+		FileValue(const FileValue&) = delete;
+		FileValue& operator=(const FileValue&) = delete;
+
+		const std::string& path() const;
+
+		// View of the mapped file, valid for the lifetime of this object.
+		// Empty if the file couldn't be read, see error.
+		std::string_view contents() const;
+		const std::string& error() const;
+
+	protected:
+		void load() const;
+
+	protected:
+		std::string filePath;
+
+		mutable std::once_flag loaded;
+		mutable std::string_view data;
+		mutable std::string loadError;
+
+		mutable void* mapping = nullptr;
+		mutable size_t mappingLength = 0;
+		mutable std::string storage; // File contents where mapping isn't available
+	};
+}
+
+#endif
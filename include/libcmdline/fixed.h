@@ -0,0 +1,356 @@
+#ifndef _h_libcmdline_fixed
+#define _h_libcmdline_fixed
+
+#include "libcmdline/cmdline.h"
+
+#include <array>
+#include <string_view>
+#include <cstdint>
+
+namespace cmdline
+{
+	enum class FixedError : uint8_t
+	{
+		none,
+		tooManyArguments, // Positional argument beyond the declared or enabled ones
+		unknownOption,    // Option or switch that doesn't exist or is disabled
+		missingArgument,  // Required positional argument without a value
+		missingOption     // Required option without a value
+	};
+
+	inline const char* fixedErrorName(FixedError error)
+	{
+		switch (error)
+		{
+		case FixedError::none: return "none";
+		case FixedError::tooManyArguments: return "too many positional arguments";
+		case FixedError::unknownOption: return "unknown option";
+		case FixedError::missingArgument: return "missing positional argument";
+		case FixedError::missingOption: return "missing option";
+		default: return "unknown";
+		}
+	}
+
+	// First error of a FixedParser parse, without any strings
+	struct FixedResult
+	{
+		FixedError error = FixedError::none;
+		size_t index = 0; // Token for token errors, entry for missing ones
+
+		explicit operator bool() const
+		{
+			return this->error == FixedError::none;
+		}
+	};
+
+	struct FixedEntry
+	{
+		static constexpr size_t NoSwitch = static_cast<size_t>(-1);
+
+		std::string_view name;
+		std::string_view defaultValue;
+		std::string_view value; // Default, or a view into the parsed tokens
+		char abbr = NoAbbr;
+		Req required = Req::optional;
+
+		bool on = false; // Switches only
+		bool given = false;
+
+		size_t dependsOn = NoSwitch; // Enabled only while this switch is on
+	};
+
+	// Parser with fixed capacities and inline storage, for processes that
+	// mustn't allocate after startup. Follows the command line syntax of
+	// Parser, without bindings, constraints, groups, actions or help.
+	// Names are views, so they must outlive the parser (eg. literals), as
+	// must the parsed tokens. Values are reset to the defaults on every
+	// parse, and only the first error is reported.
+	template <size_t MaxArguments, size_t MaxOptions, size_t MaxSwitches>
+	class FixedParser
+	{
+	public:
+		// Return nullptr when the capacity is exhausted
+		FixedEntry* addArgument(std::string_view name, std::string_view value = {}, Req required = Req::required)
+		{
+			return add(this->arguments, this->argumentCount, name, NoAbbr, value, required);
+		}
+
+		FixedEntry* addOption(std::string_view name, char abbr = NoAbbr, std::string_view value = {}, Req required = Req::optional)
+		{
+			return add(this->options, this->optionCount, name, abbr, value, required);
+		}
+
+		FixedEntry* addSwitch(std::string_view name, char abbr = NoAbbr)
+		{
+			return add(this->switches, this->switchCount, name, abbr, {}, Req::optional);
+		}
+
+		// Counterpart of enableWhenSwitchIsSet, sw must belong to this parser
+		void enableWhenSwitchIsSet(FixedEntry& entry, const FixedEntry& sw)
+		{
+			entry.dependsOn = static_cast<size_t>(&sw - this->switches.data());
+		}
+
+		// Parse given arguments, the first one is the command name
+		FixedResult parse(int argc, const char* const* argv)
+		{
+			if (argc > 0)
+				this->cmdname = argv[0];
+
+			auto begin = argv + (argc > 0 ? 1 : 0);
+			return this->parseTokens(begin, argv + (argc > 0 ? argc : 0));
+		}
+
+		FixedResult parse(const std::string_view* args, size_t count)
+		{
+			if (count > 0)
+				this->cmdname = args[0];
+
+			return this->parseTokens(args + (count > 0 ? 1 : 0), args + count);
+		}
+
+		FixedEntry* getArgument(size_t pos)
+		{
+			return pos < this->argumentCount ? &this->arguments[pos] : nullptr;
+		}
+
+		FixedEntry* getOption(std::string_view name)
+		{
+			return find(this->options, this->optionCount, name);
+		}
+
+		FixedEntry* getOption(char abbr)
+		{
+			return find(this->options, this->optionCount, abbr);
+		}
+
+		FixedEntry* getSwitch(std::string_view name)
+		{
+			return find(this->switches, this->switchCount, name);
+		}
+
+		FixedEntry* getSwitch(char abbr)
+		{
+			return find(this->switches, this->switchCount, abbr);
+		}
+
+		std::string_view getCommandName() const
+		{
+			return this->cmdname;
+		}
+
+	protected:
+		template <size_t N>
+		static FixedEntry* add(std::array<FixedEntry, N>& entries, size_t& count, std::string_view name, char abbr, std::string_view value, Req required)
+		{
+			if (count == N)
+				return nullptr;
+
+			FixedEntry& entry = entries[count++];
+			entry = FixedEntry();
+			entry.name = name;
+			entry.defaultValue = value;
+			entry.value = value;
+			entry.abbr = abbr;
+			entry.required = required;
+			return &entry;
+		}
+
+		template <size_t N>
+		static FixedEntry* find(std::array<FixedEntry, N>& entries, size_t count, std::string_view name)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				if (entries[i].name == name)
+					return &entries[i];
+			}
+			return nullptr;
+		}
+
+		template <size_t N>
+		static FixedEntry* find(std::array<FixedEntry, N>& entries, size_t count, char abbr)
+		{
+			for (size_t i = 0; abbr != NoAbbr && i < count; i++)
+			{
+				if (entries[i].abbr == abbr)
+					return &entries[i];
+			}
+			return nullptr;
+		}
+
+		static std::string_view optionName(std::string_view arg)
+		{
+			size_t equals = arg.find_first_of('=');
+			return arg.substr(2, equals == std::string_view::npos ? equals : equals - 2);
+		}
+
+		bool isEnabled(const FixedEntry& entry) const
+		{
+			return entry.dependsOn == FixedEntry::NoSwitch || this->switches[entry.dependsOn].on;
+		}
+
+		template <typename It>
+		FixedResult parseTokens(It begin, It end)
+		{
+			for (size_t i = 0; i < this->argumentCount; i++)
+				this->reset(this->arguments[i]);
+			for (size_t i = 0; i < this->optionCount; i++)
+				this->reset(this->options[i]);
+			for (size_t i = 0; i < this->switchCount; i++)
+				this->reset(this->switches[i]);
+
+			FixedResult result;
+			auto fail = [&result](FixedError error, size_t index) {
+				if (result)
+					result = { error, index };
+			};
+
+			// Used to fill option's value in the "--option value syntax"
+			FixedEntry* activeOption = nullptr;
+
+			// Everything after "--" is positional
+			bool terminated = false;
+
+			size_t pos = 0;
+			size_t token = 0;
+			for (auto it = begin; it != end; it++, token++)
+			{
+				std::string_view arg = *it;
+
+				if (activeOption)
+				{
+					activeOption->value = arg;
+					activeOption = nullptr;
+					continue;
+				}
+
+				if (!terminated && arg == "--")
+				{
+					terminated = true;
+					continue;
+				}
+
+				if (terminated || (!Parser::isOption(arg) && !Parser::isOptionAbbr(arg)))
+				{
+					if (!this->parseArgument(arg, pos))
+						fail(FixedError::tooManyArguments, token);
+					continue;
+				}
+
+				if (!this->parseOption(arg, &activeOption) && !this->parseSwitch(arg))
+					fail(FixedError::unknownOption, token);
+			}
+
+			for (size_t i = 0; i < this->argumentCount; i++)
+			{
+				const FixedEntry& arg = this->arguments[i];
+				if (this->isEnabled(arg) && arg.required == Req::required && arg.value.empty())
+					fail(FixedError::missingArgument, i);
+			}
+
+			for (size_t i = 0; i < this->optionCount; i++)
+			{
+				const FixedEntry& opt = this->options[i];
+				if (this->isEnabled(opt) && opt.required == Req::required && opt.value.empty())
+					fail(FixedError::missingOption, i);
+			}
+
+			return result;
+		}
+
+		void reset(FixedEntry& entry)
+		{
+			entry.value = entry.defaultValue;
+			entry.on = false;
+			entry.given = false;
+		}
+
+		bool parseArgument(std::string_view arg, size_t& pos)
+		{
+			if (pos >= this->argumentCount || !this->isEnabled(this->arguments[pos]))
+				return false;
+
+			FixedEntry& argument = this->arguments[pos++];
+			argument.value = arg;
+			argument.given = true;
+			return true;
+		}
+
+		bool parseOption(std::string_view arg, FixedEntry** activeOption)
+		{
+			bool abbr = Parser::isOptionAbbr(arg);
+			FixedEntry* option = abbr ? this->getOption(arg[1]) : this->getOption(optionName(arg));
+
+			// Unknown options may still be switches
+			if (!option || !this->isEnabled(*option))
+				return false;
+
+			option->given = true;
+
+			size_t equals = arg.find_first_of('=');
+			if (abbr)
+			{
+				if (equals != std::string_view::npos && equals + 1 < arg.size())
+					option->value = arg.substr(equals + 1);
+				else if (arg.size() > 2) // For cases like -x42
+					option->value = arg.substr(2);
+				else // For cases like -x 42
+					*activeOption = option;
+				return true;
+			}
+
+			// For cases like --xyz=42 and --xyz 42
+			if (equals != std::string_view::npos)
+				option->value = arg.substr(equals + 1);
+			else
+				*activeOption = option;
+			return true;
+		}
+
+		bool parseSwitch(std::string_view arg)
+		{
+			if (Parser::isOptionAbbr(arg))
+			{
+				// For cases like -x or -xyz
+				for (char c : arg.substr(1))
+				{
+					FixedEntry* sw = this->getSwitch(c);
+					if (!sw || !this->isEnabled(*sw))
+						return false;
+					sw->on = true;
+					sw->given = true;
+				}
+				return true;
+			}
+
+			// For cases like --xyz or --no-xyz
+			std::string_view name = optionName(arg);
+			FixedEntry* sw = this->getSwitch(name);
+			bool value = true;
+			if (!sw && name.substr(0, 3) == "no-")
+			{
+				sw = this->getSwitch(name.substr(3));
+				value = false;
+			}
+
+			if (!sw || !this->isEnabled(*sw))
+				return false;
+			sw->on = value;
+			sw->given = true;
+			return true;
+		}
+
+	protected:
+		std::string_view cmdname;
+
+		std::array<FixedEntry, MaxArguments> arguments {};
+		std::array<FixedEntry, MaxOptions> options {};
+		std::array<FixedEntry, MaxSwitches> switches {};
+
+		size_t argumentCount = 0;
+		size_t optionCount = 0;
+		size_t switchCount = 0;
+	};
+}
+
+#endif
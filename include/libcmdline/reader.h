@@ -0,0 +1,76 @@
+#ifndef _h_libcmdline_reader
+#define _h_libcmdline_reader
+
+#include "libcmdline/cmdline.h"
+
+#include <string>
+#include <string_view>
+
+namespace cmdline
+{
+	// Reads newline separated command lines from a file descriptor (pipe,
+	// socket, terminal) and parses each with Parser::parseLine. Blank and
+	// comment lines are skipped. The read buffer is reused and only grows
+	// for lines longer than any seen before.
+	class CommandReader
+	{
+	public:
+		CommandReader(Parser& parser, int fd, size_t bufferSize = 4096);
+
+		// Read and parse the next line. Returns false at the end of the stream.
+		bool next(ParseResult& result);
+
+		// Line parsed by the last next call, valid until the following one
+		std::string_view line() const;
+
+	protected:
+		// Read more data into the buffer, returns false at the end of the stream
+		bool fill();
+
+	protected:
+		Parser& parser;
+		int fd;
+
+		std::string buffer;
+		size_t begin = 0;
+		size_t end = 0;
+		bool eof = false;
+
+		std::string_view current;
+	};
+
+	// Parses many NUL separated command lines, eg. /proc/<pid>/cmdline of
+	// every process on a host. The read buffer, the parse result and the
+	// entry values are reused, so a scan allocates only when a command line
+	// is longer than any before. Entries not given on a command line get the
+	// values they had when the scanner was created.
+	class CmdlineScanner
+	{
+	public:
+		CmdlineScanner(Parser& parser, size_t bufferSize = 4096);
+
+		// Parse a command line held by the caller
+		const ParseResult& parse(std::string_view buffer);
+
+		// Read a whole file into the buffer and parse it. Returns false if
+		// the file can't be read, eg. the process has exited.
+		bool parseFile(const std::string& path);
+
+		// Result of the last parse, valid until the next one
+		const ParseResult& result() const;
+
+		// Contents of the file read by the last parseFile
+		std::string_view buffer() const;
+
+	protected:
+		Parser& parser;
+		ReloadValues defaults;
+
+		std::string data;
+		size_t size = 0;
+
+		ParseResult last;
+	};
+}
+
+#endif
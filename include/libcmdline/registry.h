@@ -0,0 +1,83 @@
+#ifndef _h_libcmdline_registry
+#define _h_libcmdline_registry
+
+#include "libcmdline/convert.h"
+
+#include <type_traits>
+
+namespace cmdline
+{
+	// Option or switch declared at namespace scope by any translation unit.
+	// Declaring one only links it into a process wide list, nothing is
+	// allocated until a parser that called Parser::useRegistry first needs
+	// its entries.
+	class RegisteredFlag
+	{
+	public:
+		RegisteredFlag(const RegisteredFlag&) = delete;
+		RegisteredFlag& operator=(const RegisteredFlag&) = delete;
+
+		// Most recently registered flag, follow next for the others
+		static const RegisteredFlag* first();
+
+		const char* name;
+		char abbr;
+		const char* description;
+		bool isSwitch;
+		Binding binding;
+
+		const RegisteredFlag* next = nullptr;
+
+	protected:
+		RegisteredFlag(const char* name, char abbr, const char* description, bool isSwitch)
+			: name(name)
+			, abbr(abbr)
+			, description(description)
+			, isSwitch(isSwitch)
+		{ }
+
+		// Lock-free, flags of libraries loaded at runtime may register
+		// while other threads are parsing
+		void enroll();
+	};
+
+	// Typed flag holding its value, bool flags are switches:
+	//
+	//   cmdline::Flag<int> threads("threads", 'j', 4, "Worker threads");
+	//   ...
+	//   parser.useRegistry();
+	//   parser.parse(argc, argv);
+	//   run(*threads);
+	template <typename T>
+	class Flag : public RegisteredFlag
+	{
+	public:
+		Flag(const char* name, char abbr, T value, const char* description = "")
+			: RegisteredFlag(name, abbr, description, std::is_same_v<T, bool>)
+			, value(std::move(value))
+		{
+			this->binding = bind(this->value);
+			this->enroll();
+		}
+
+		const T& get() const
+		{
+			return this->value;
+		}
+
+		const T& operator*() const
+		{
+			return this->value;
+		}
+
+		const T* operator->() const
+		{
+			return &this->value;
+		}
+
+	protected:
+		T value;
+	};
+}
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef _h_libcmdline_schema
+#define _h_libcmdline_schema
+
+#include "libcmdline/cmdline.h"
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace cmdline
+{
+	constexpr uint32_t SchemaBlobVersion = 2;
+
+	// Read-only view of a single schema entry stored in a blob
+	struct SchemaEntry
+	{
+		ArgKind kind;
+		std::string_view name;
+		std::string_view value;
+		std::string_view description;
+		char abbr = NoAbbr;
+		Req required = Req::optional;
+		int section = -1; // Index into the blob help sections, -1 if none
+		size_t helpIndex = 0;
+	};
+
+	// Another name or abbreviation of an option or switch
+	struct SchemaAlias
+	{
+		size_t entry = 0;
+		std::string_view name; // Empty for abbreviation aliases
+		char abbr = NoAbbr;
+	};
+
+	// Frozen parser schema written by Parser::saveSchema. The blob is position
+	// independent (all references are offsets) and holds the entries, help
+	// sections, help text and the name and abbreviation lookup index, so it
+	// can be used straight from a read-only memory mapping.
+	//
+	// Predicates and bindings can't be stored, set them on the entries
+	// returned by Parser lookups after Parser::setSchema.
+	class SchemaBlob
+	{
+	public:
+		static constexpr size_t npos = static_cast<size_t>(-1);
+
+		SchemaBlob() = default;
+		~SchemaBlob();
+
+		SchemaBlob(const SchemaBlob&) = delete;
+		SchemaBlob& operator=(const SchemaBlob&) = delete;
+
+		// Map a schema file read-only
+		ParseResult open(const std::string& path);
+
+		// Use a schema already in memory, eg. embedded in the executable.
+		// The data must be 4-byte aligned and outlive the blob.
+		ParseResult load(const void* data, size_t size);
+
+		size_t size() const;
+		SchemaEntry entry(size_t i) const;
+
+		// Entry index, or npos if there's no such entry
+		size_t find(std::string_view name, ArgKind kind) const;
+		size_t find(char abbr, ArgKind kind) const;
+
+		size_t sectionCount() const;
+		HelpSection section(size_t i) const;
+
+		// Aliases, ordered by entry index
+		size_t aliasCount() const;
+		SchemaAlias alias(size_t i) const;
+
+		std::string_view help() const;
+
+		// Indices of required entries, used to validate entries never looked up
+		size_t requiredCount() const;
+		size_t required(size_t i) const;
+
+	protected:
+		void close();
+
+		std::string_view string(const uint32_t* ref) const;
+		const uint32_t* words(uint32_t offset) const;
+
+	protected:
+		const unsigned char* data = nullptr;
+		size_t length = 0;
+
+		void* mapping = nullptr;
+		size_t mappingLength = 0;
+		std::string storage; // File contents where mapping isn't available
+	};
+}
+
+#endif
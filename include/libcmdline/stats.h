@@ -0,0 +1,96 @@
+#ifndef _h_libcmdline_stats
+#define _h_libcmdline_stats
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+namespace cmdline
+{
+#ifdef LIBCMDLINE_INSTRUMENTATION
+	constexpr bool InstrumentationEnabled = true;
+#else
+	constexpr bool InstrumentationEnabled = false; // Stats are never recorded
+#endif
+
+	// Parser activities measured by the instrumentation
+	enum class Phase
+	{
+		schema,   // addArgument, addOption, addSwitch, addHelpSection
+		parse,    // Parser::parse
+		validate, // validateArguments, validateOptions, validateCommand
+		help,     // getHelp
+
+		count
+	};
+
+	const char* phaseName(Phase phase);
+
+	struct PhaseStats
+	{
+		uint64_t calls = 0;
+		uint64_t nanoseconds = 0;
+		uint64_t allocations = 0;
+	};
+
+	// Single measured span, used for the Chrome trace export
+	struct TraceEvent
+	{
+		Phase phase;
+		uint64_t start = 0; // Nanoseconds since the stats were reset
+		uint64_t duration = 0;
+	};
+
+	struct ParserStats
+	{
+		PhaseStats phases[static_cast<size_t>(Phase::count)] = {};
+
+		uint64_t tokens = 0;               // Command line tokens visited by parse
+		uint64_t lookups = 0;              // getArgument, getOption and getSwitch calls
+		uint64_t predicateEvaluations = 0; // ArgumentEnablePred calls made by the parser
+
+		std::vector<TraceEvent> events;
+
+		const PhaseStats& operator[](Phase phase) const
+		{
+			return this->phases[static_cast<size_t>(phase)];
+		}
+
+		PhaseStats& operator[](Phase phase)
+		{
+			return this->phases[static_cast<size_t>(phase)];
+		}
+
+		// Export recorded spans in Chrome trace event format (chrome://tracing, Perfetto)
+		std::string toChromeTrace() const;
+	};
+
+	namespace detail
+	{
+		// Number of heap allocations made by the calling thread. Only counted
+		// in instrumented builds, which replace the global operator new.
+		uint64_t allocationCount();
+
+#ifdef LIBCMDLINE_INSTRUMENTATION
+		// Records a phase span into the stats for the lifetime of the object.
+		// Nested scopes of an already active phase are not recorded twice.
+		class PhaseScope
+		{
+		public:
+			PhaseScope(ParserStats& stats, unsigned& activePhases, std::chrono::steady_clock::time_point epoch, Phase phase);
+			~PhaseScope();
+
+		private:
+			ParserStats* stats = nullptr;
+			unsigned* activePhases = nullptr;
+			std::chrono::steady_clock::time_point epoch;
+			std::chrono::steady_clock::time_point start;
+			uint64_t allocations = 0;
+			Phase phase;
+		};
+#endif
+	}
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef _h_libcmdline_tokenizer
+#define _h_libcmdline_tokenizer
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+
+namespace cmdline
+{
+	// Splits a command line into arguments following shell rules: whitespace
+	// separates arguments, single quotes are literal, double quotes and
+	// backslashes escape, and # starts a comment. Unescaped arguments are
+	// written into an internal buffer that's reused between calls.
+	class LineTokenizer
+	{
+	public:
+		// Returns false if the line is malformed, see error()
+		bool tokenize(std::string_view line);
+
+		// Views into the tokenizer buffer, valid until the next tokenize call
+		const std::vector<std::string_view>& tokens() const;
+
+		const char* error() const;
+
+	protected:
+		std::string buffer;
+		std::vector<std::pair<size_t, size_t>> spans;
+		std::vector<std::string_view> views;
+		const char* errorMsg = nullptr;
+	};
+}
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef _h_libcmdline_usage
+#define _h_libcmdline_usage
+
+#include "libcmdline/cmdline.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace cmdline
+{
+	// Usage of a single option or switch. Updated with relaxed atomic
+	// increments, so parsers on several threads can share a recorder.
+	struct UsageCounters
+	{
+		std::atomic<uint64_t> given { 0 };     // Parses the entry was given in
+		std::atomic<uint64_t> defaulted { 0 }; // Parses it was left at its default
+		std::atomic<uint64_t> rejected { 0 };  // Values refused, or given while disabled
+	};
+
+	struct UsageEntry
+	{
+		std::string name;
+		uint64_t given = 0;
+		uint64_t defaulted = 0;
+		uint64_t rejected = 0;
+	};
+
+	// Opt-in record of which options a program is run with, see
+	// Parser::setUsageRecorder. Counters are flushed as blocks appended to a
+	// local file, one line per entry:
+	//
+	//   usage 1 <parses>
+	//   o <given> <defaulted> <rejected> <name>
+	//   u <hash> <count>
+	//
+	// where u lines count unknown option tokens by their FNV-1a hash, eg. of
+	// "--legacy-flag". merge reads such files back, eg. into an aggregator.
+	class UsageRecorder
+	{
+	public:
+		static constexpr size_t UnknownSlots = 256; // Further unknown tokens are dropped
+
+		UsageRecorder() = default;
+
+		UsageRecorder(const UsageRecorder&) = delete;
+		UsageRecorder& operator=(const UsageRecorder&) = delete;
+
+		// Counters of an entry, created on first use. The reference stays valid
+		// for the lifetime of the recorder.
+		UsageCounters& counters(std::string_view name);
+
+		void recordParse();
+		void recordUnknown(std::string_view token);
+
+		uint64_t parses() const;
+		std::vector<UsageEntry> entries() const;
+		std::vector<std::pair<uint32_t, uint64_t>> unknown() const;
+
+		// Append the counters gathered since the last flush and reset them
+		ParseResult flush(const std::string& path);
+
+		// Add the counters of every block in a usage file
+		ParseResult merge(const std::string& path);
+
+	protected:
+		// Lock-free insert into the fixed unknown token table
+		void addUnknown(uint32_t hash, uint64_t count);
+
+	protected:
+		struct UnknownSlot
+		{
+			std::atomic<uint32_t> hash { 0 };
+			std::atomic<uint64_t> count { 0 };
+		};
+
+		mutable std::mutex mutex; // Guards adding counters, never taken by increments
+		std::map<std::string, UsageCounters, std::less<>> named;
+		std::atomic<uint64_t> parseCount { 0 };
+		UnknownSlot unknownSlots[UnknownSlots];
+	};
+}
+
+#endif
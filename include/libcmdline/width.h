@@ -0,0 +1,18 @@
+#ifndef _h_libcmdline_width
+#define _h_libcmdline_width
+
+#include <cstddef>
+#include <string_view>
+
+namespace cmdline
+{
+	// Number of terminal columns taken by UTF-8 text. Wide (eg. CJK)
+	// characters take two columns and combining marks none. ASCII and
+	// invalid bytes count as one column each.
+	size_t displayWidth(std::string_view text);
+
+	// Column width of a single code point
+	int codepointWidth(char32_t cp);
+}
+
+#endif
@@ -1,14 +1,41 @@
 #include "libcmdline/cmdline.h"
+#include "libcmdline/schema.h"
+#include "libcmdline/width.h"
+#include "libcmdline/events.h"
+#include "libcmdline/usage.h"
+#include "instrumentation.h"
 
 #include <cstdarg>
 #include <cstdio>
 #include <functional>
 #include <sstream>
-#include <iomanip>
 #include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
 
 namespace cmdline
 {
+	namespace
+	{
+		// Non-allocating counterparts of Parser::getOptionName and Parser::getNameEqualsValue
+
+		std::string_view optionName(std::string_view arg)
+		{
+			size_t equals = arg.find_first_of('=');
+			return arg.substr(2, equals == std::string_view::npos ? equals : equals - 2);
+		}
+
+		std::pair<std::string_view, std::string_view> nameEqualsValue(std::string_view arg)
+		{
+			size_t eqpos = arg.find_first_of('=');
+			if (eqpos == std::string_view::npos)
+				return {};
+			std::string_view name = arg.substr(0, eqpos);
+			return { name.size() > 2 ? optionName(name) : std::string_view(), arg.substr(eqpos + 1) };
+		}
+	}
+
 	// Dependency preds
 	
 	ArgumentEnablePred enableAlways()
@@ -18,9 +45,35 @@ namespace cmdline
 		};
 	}
 
+	namespace
+	{
+		// States of the parser evaluating a predicate, see Parser::isEnabled
+		thread_local const ArgumentStates* evaluatingStates = nullptr;
+
+		// Switches read by predicates while Parser::freeze checks them, by
+		// origin and id
+		thread_local std::vector<std::pair<uint64_t, size_t>>* probedSwitches = nullptr;
+	}
+
 	ArgumentEnablePred enableWhenSwitchIsSet(const Switch& s)
 	{
-		return [&s](){
+		// Parsers sharing the switch's origin (copies and parsers built on a
+		// shared base) read their own state of the switch, so the predicate
+		// never follows the parser it was created with
+		uint64_t origin = s.states ? s.states->getOrigin() : 0;
+		size_t id = s.id;
+		return [&s, origin, id](){
+			bool own = origin && evaluatingStates && evaluatingStates->getOrigin() == origin;
+			if (probedSwitches)
+			{
+				// The switch may be gone if it belongs to another parser
+				probedSwitches->emplace_back(origin, id);
+				if (!own)
+					return false;
+			}
+
+			if (own)
+				return evaluatingStates->on(id);
 			return s.on();
 		};
 	}
@@ -41,6 +94,9 @@ namespace cmdline
 	ParseResult& ParseResult::operator=(const ParseResult& b)
 	{
 		this->errors = b.errors;
+		this->isStopped = b.isStopped;
+		this->stopName = b.stopName;
+		this->files = b.files;
 		return *this;
 	}
 
@@ -52,6 +108,7 @@ namespace cmdline
 	bool ParseResult::merge(const ParseResult& res)
 	{
 		this->errors.insert(this->errors.end(), res.errors.begin(), res.errors.end());
+		this->files.insert(this->files.end(), res.files.begin(), res.files.end());
 		return res;
 	}
 
@@ -65,6 +122,34 @@ namespace cmdline
 		return result;
 	}
 
+	ParseStatus ParseResult::status() const
+	{
+		if (this->isStopped)
+			return ParseStatus::stopped;
+		return this->errors.empty() ? ParseStatus::ok : ParseStatus::failed;
+	}
+
+	bool ParseResult::stopped() const
+	{
+		return this->isStopped;
+	}
+
+	const std::string& ParseResult::stoppedBy() const
+	{
+		return this->stopName;
+	}
+
+	void ParseResult::stop(const std::string& name)
+	{
+		this->isStopped = true;
+		this->stopName = name;
+	}
+
+	void ParseResult::keep(std::shared_ptr<const FileValue> file)
+	{
+		this->files.push_back(std::move(file));
+	}
+
 	ArgumentParseResult::ArgumentParseResult(bool accepted, const std::string& error)
 		: ParseResult(error.empty() ? std::vector<std::string>{} : std::vector<std::string>{ error })
 		, accepted(accepted)
@@ -83,6 +168,14 @@ namespace cmdline
 		return this->accepted;
 	}
 
+	// ArgumentStates
+
+	uint64_t ArgumentStates::nextOrigin()
+	{
+		static std::atomic<uint64_t> next { 1 };
+		return next.fetch_add(1, std::memory_order_relaxed);
+	}
+
 	// Parser
 
 	Parser::Parser(bool autohelp)
@@ -92,95 +185,421 @@ namespace cmdline
 			this->addStandardHelpSwitch();
 	}
 
+	Parser::Parser(const Parser& b)
+		: Parser(false)
+	{
+		*this = b;
+	}
+
+	Parser& Parser::operator=(const Parser& b)
+	{
+		if (this == &b)
+			return *this;
+
+		this->cmdname = b.cmdname;
+		this->args = b.args;
+		this->options = b.options;
+		this->switches = b.switches;
+		this->schema = b.schema;
+		this->materialized = b.materialized;
+		this->schemaSectionBase = b.schemaSectionBase;
+		this->helpSections = b.helpSections;
+		this->groups = b.groups;
+		this->optionCount = b.optionCount;
+		this->states = std::make_unique<ArgumentStates>(*b.states);
+		this->helpId = b.helpId;
+		this->versionId = b.versionId;
+		this->version = b.version;
+		this->autohelp = b.autohelp;
+		this->helpMaxWidth = b.helpMaxWidth;
+		this->helpMaxArgWidth = b.helpMaxArgWidth;
+		this->helpPred = b.helpPred;
+		this->descriptionProvider = b.descriptionProvider;
+		this->usage = b.usage;
+		this->usageSlots = b.usageSlots;
+		this->reloaded = b.reloaded;
+		this->reloadDefaults = b.reloadDefaults;
+		this->reloadApplied = b.reloadApplied;
+		this->changeCallbacks = b.changeCallbacks;
+		this->frozen = b.frozen;
+		this->registryPending = b.registryPending;
+		this->base = b.base;
+		this->inherited = b.inherited;
+		this->baseRequired = b.baseRequired;
+		this->tokenizer = b.tokenizer;
+		this->stats = b.stats;
+#ifdef LIBCMDLINE_INSTRUMENTATION
+		this->activePhases = 0;
+		this->statsEpoch = b.statsEpoch;
+#endif
+
+		// Point the copied entries at this parser's state and help sections
+		for (Switch& sw : this->switches)
+			sw.states = this->states.get();
+
+		this->index.clear();
+		this->positional.clear();
+		for (Argument& arg : this->args)
+			this->positional.push_back(&arg);
+		this->variadicPos = b.variadicPos;
+		this->variadicMin = b.variadicMin;
+		this->variadicMax = b.variadicMax;
+		this->variadicValues = b.variadicValues;
+		for (Option& opt : this->options)
+			this->index.add(opt, ArgKind::option);
+		for (Switch& sw : this->switches)
+			this->index.add(sw, ArgKind::switch_);
+
+		for (Argument& arg : this->args)
+			this->rebindSection(arg, b);
+		for (Option& opt : this->options)
+			this->rebindSection(opt, b);
+		for (Switch& sw : this->switches)
+			this->rebindSection(sw, b);
+
+		return *this;
+	}
+
 	ParseResult Parser::parse(int argc, char** argv)
 	{
-		return this->parse(std::vector<std::string>(argv, argv + argc));
+		CMDLINE_PHASE(Phase::parse);
+		if (argc > 0)
+			this->cmdname = argv[0];
+		return this->parseTokens(argv + std::min(argc, 1), argv + argc);
 	}
 
 	ParseResult Parser::parse(const std::vector<std::string>& args)
 	{
-		assert(this->validateCommand() && "Command is ill-formed");
+		CMDLINE_PHASE(Phase::parse);
+		if (!args.empty())
+			this->cmdname = args.front();
+		return this->parseTokens(args.begin() + std::min<size_t>(args.size(), 1), args.end());
+	}
+
+	ParseResult Parser::parseLine(std::string_view line)
+	{
+		CMDLINE_PHASE(Phase::parse);
+		if (!this->tokenizer.tokenize(line))
+			return ParseResult({ this->tokenizer.error() });
+
+		const auto& tokens = this->tokenizer.tokens();
+		return this->parseTokens(tokens.begin(), tokens.end());
+	}
+
+	namespace
+	{
+		// Tokens of a NUL separated buffer, the last one may end without a NUL
+		class NulSeparatedTokens
+		{
+		public:
+			NulSeparatedTokens(const char* pos, const char* end)
+				: pos(pos)
+				, end(end)
+			{
+				this->measure();
+			}
+
+			std::string_view operator*() const
+			{
+				return std::string_view(this->pos, this->length);
+			}
+
+			NulSeparatedTokens operator++(int)
+			{
+				NulSeparatedTokens prev = *this;
+				this->pos = std::min(this->pos + this->length + 1, this->end);
+				this->measure();
+				return prev;
+			}
+
+			bool operator!=(const NulSeparatedTokens& b) const
+			{
+				return this->pos != b.pos;
+			}
+
+		protected:
+			void measure()
+			{
+				const void* nul = std::memchr(this->pos, '\0', this->end - this->pos);
+				this->length = (nul ? static_cast<const char*>(nul) : this->end) - this->pos;
+			}
+
+		protected:
+			const char* pos;
+			const char* end;
+			size_t length = 0;
+		};
+	}
+
+	ParseResult Parser::parseBuffer(std::string_view buffer)
+	{
+		CMDLINE_PHASE(Phase::parse);
+		const char* end = buffer.data() + buffer.size();
+		NulSeparatedTokens it(buffer.data(), end);
+		NulSeparatedTokens last(end, end);
+		if (it != last)
+			this->cmdname = *it++;
+		return this->parseTokens(it, last);
+	}
+
+	template <typename It>
+	ParseResult Parser::parseTokens(It begin, It end)
+	{
+		assert((this->frozen || this->validateCommand()) && "Command is ill-formed");
 
 		ParseResult result;
+		this->states->clearGiven();
+		this->variadicValues.clear();
+		this->stopper = nullptr;
 
 		// Used to fill option's value in the "--option value syntax"
 		Option* activeOption = nullptr;
 
-		if (!args.empty())
-			this->cmdname = args.front();
+		// Everything after "--" is positional
+		bool terminated = false;
 
 		size_t pos = 0;
-		for (auto it = args.begin() + 1; it != args.end(); it++)
+		for (auto it = begin; it != end && !this->stopper; it++)
 		{
-			const std::string& arg = *it;
+			std::string_view arg = *it;
+			CMDLINE_COUNT(tokens);
 
 			if (activeOption)
 			{
-				activeOption->value = arg;
+				this->markGiven(*activeOption);
+				if (result.merge(this->assignValue(*activeOption, arg)))
+					this->runAction(*activeOption);
 				activeOption = nullptr;
 				continue;
 			}
 
+			if (terminated)
+			{
+				result.merge(this->parseArgument(arg, pos));
+				continue;
+			}
+
+			if (arg == "--")
+			{
+				terminated = true;
+				continue;
+			}
+
+			// Accepted tokens may still report errors, eg. values failing conversion
 			ArgumentParseResult argres { false };
-			if (argres.merge(this->parseArgument(arg, pos)))
+			auto accepted = [&result, &argres](const ArgumentParseResult& res) {
+				if (!res)
+					return argres.merge(res);
+				result.merge(res);
+				return true;
+			};
+
+			if (!isOption(arg) && !isOptionAbbr(arg) && accepted(this->parseArgument(arg, pos)))
 				continue;
-			if (argres.merge(this->parseOption(arg, &activeOption)))
+			if (accepted(this->parseOption(arg, &activeOption)))
 				continue;
-			if (argres.merge(this->parseSwitch(arg)))
+			if (accepted(this->parseSwitch(arg)))
 				continue;
 
+			if (isOption(arg) || isOptionAbbr(arg))
+			{
+				if (this->usage)
+					this->usage->recordUnknown(arg);
+				result.merge(ArgumentParseResult(false, std::string("This command does not accept \"") + std::string(arg) + "\" option"));
+			}
 			result.merge(argres);
 		}
 
+		if (this->stopper)
+		{
+			result.stop(this->stopper->name);
+			this->stopper = nullptr;
+			if (this->usage)
+				this->recordUsage();
+			return result;
+		}
+
 		result.merge(this->validateArguments());
 		result.merge(this->validateOptions());
+		result.merge(this->validateGroups());
+
+		if (this->usage)
+			this->recordUsage();
 
 		return result;
 	}
 
-	ArgumentParseResult Parser::parseArgument(const std::string& arg, size_t& pos)
+	size_t Parser::readEvent(std::string_view token, const std::string_view* next, EventCursor& cursor, ParseEvent& event) const
 	{
-		if (isOption(arg) || isOptionAbbr(arg))
-			return false;
+		event = ParseEvent();
+		event.token = token;
 
-		Argument* argument = this->getArgument(pos);
-		if (!argument || !argument->enabled())
-			//return false;
-			return {false, std::string("This command does not accept ") + std::to_string(pos + 1) + " positional arguments"};
+		if (cursor.offset == 0)
+			CMDLINE_COUNT(tokens);
 
-		if (!argument->enabled())
-			return false;
+		if (!cursor.terminated && token == "--")
+		{
+			cursor.terminated = true;
+			event.kind = EventKind::terminator;
+			return 1;
+		}
+
+		if (cursor.terminated || (!isOption(token) && !isOptionAbbr(token)))
+		{
+			event.kind = EventKind::positional;
+			event.value = token;
+			event.position = cursor.position++;
+			if (event.position < this->positional.size())
+				event.entry = this->positional[event.position];
+			else if (this->variadicPos != NoId)
+				event.entry = this->positional[this->variadicPos];
+			return 1;
+		}
+
+		if (isOption(token))
+		{
+			auto nameVal = nameEqualsValue(token);
+			event.name = nameVal.first.empty() ? optionName(token) : nameVal.first;
+
+			if (const Option* opt = this->getOption(event.name))
+			{
+				event.kind = EventKind::option;
+				event.entry = opt;
+
+				// For cases like --xyz=42 and --xyz 42
+				if (!nameVal.first.empty())
+					event.value = nameVal.second;
+				else if (next)
+				{
+					event.value = *next;
+					return 2;
+				}
+				else
+					event.missingValue = true;
+				return 1;
+			}
+
+			const Switch* sw = this->getSwitch(event.name);
+			if (!sw && event.name.substr(0, 3) == "no-")
+			{
+				sw = this->getSwitch(event.name.substr(3));
+				event.on = false;
+			}
+
+			event.kind = sw ? EventKind::switch_ : EventKind::unknown;
+			event.entry = sw;
+			return 1;
+		}
+
+		if (cursor.offset == 0)
+		{
+			if (const Option* opt = this->getOption(token[1]))
+			{
+				event.kind = EventKind::option;
+				event.entry = opt;
+				event.name = token.substr(1, 1);
+
+				// For cases like -x=42, -x42 and -x 42
+				auto nameVal = nameEqualsValue(token);
+				if (!nameVal.second.empty())
+					event.value = nameVal.second;
+				else if (token.size() > 2)
+					event.value = token.substr(2);
+				else if (next)
+				{
+					event.value = *next;
+					return 2;
+				}
+				else
+					event.missingValue = true;
+				return 1;
+			}
+			cursor.offset = 1;
+		}
+
+		// One switch of -xyz at a time
+		event.name = token.substr(cursor.offset, 1);
+		const Switch* sw = this->getSwitch(token[cursor.offset]);
+		event.kind = sw ? EventKind::switch_ : EventKind::unknown;
+		event.entry = sw;
+
+		if (++cursor.offset < token.size())
+			return 0;
+		cursor.offset = 0;
+		return 1;
+	}
+
+	ArgumentParseResult Parser::parseArgument(std::string_view arg, size_t& pos)
+	{
+		Argument* argument = this->getArgument(std::min(pos, this->variadicPos));
+		bool variadic = argument && pos >= this->variadicPos;
+		if (
+			!argument ||
+			!this->isEnabled(*argument) ||
+			(variadic && this->variadicMax && this->variadicValues.size() >= this->variadicMax)
+		)
+			return {false, std::string("This command does not accept ") + std::to_string(pos + 1) + " positional arguments"};
 
-		argument->value = arg;
 		pos++;
+		if (!variadic)
+		{
+			ArgumentParseResult res = this->assignValue(*argument, arg);
+			if (res.ParseResult::operator bool())
+				this->runAction(*argument);
+			return res;
+		}
 
-		return true;
+		// Kept as a view, the value only holds the first one so that the
+		// argument reports having a value
+		this->variadicValues.push_back(arg);
+		if (argument->binding)
+			return this->assignValue(*argument, arg);
+
+		ArgumentParseResult res = this->checkValue(*argument, arg);
+		if (res.ParseResult::operator bool() && this->variadicValues.size() == 1)
+			argument->value.assign(arg.data(), arg.size());
+		return res;
 	}
 
-	ArgumentParseResult Parser::parseOption(const std::string& arg, Option** activeOption)
+	ArgumentParseResult Parser::parseOption(std::string_view arg, Option** activeOption)
 	{
 		Option* option = nullptr;
 		bool abbr = false;
 		if (isOption(arg))
-			option = this->getOption(getOptionName(arg));
+			option = this->getOption(optionName(arg));
 		else if (isOptionAbbr(arg))
 		{
-			option = this->getOption(getOptionAbbr(arg).front());
+			option = this->getOption(arg[1]);
 			abbr = true;
 		}
 		else
 			return false;
 
-		if (!option || !option->enabled())
-			return {false, std::string("This command does not accept \"") + arg + "\" option"};
+		// Unknown options are reported by parseTokens, as the token may still be a switch
+		if (!option)
+			return false;
+		if (!this->isEnabled(*option))
+		{
+			this->recordRejected(*option);
+			return false;
+		}
 
-		auto nameVal = getNameEqualsValue(arg);
+		this->markGiven(*option);
+
+		auto assign = [this, option](std::string_view value) {
+			ArgumentParseResult res = this->assignValue(*option, value);
+			if (res.ParseResult::operator bool())
+				this->runAction(*option);
+			return res;
+		};
+
+		auto nameVal = nameEqualsValue(arg);
 		if (abbr)
 		{
 			if (!nameVal.second.empty())
-				option->value = nameVal.second;
+				return assign(nameVal.second);
 			else if (arg.length() > 2) // For cases like -x42
-				option->value = arg.substr(2);
+				return assign(arg.substr(2));
 			else // For cases like -x 42
 				*activeOption = option;
 			return true;
@@ -189,8 +608,7 @@ namespace cmdline
 		if (!nameVal.first.empty())
 		{
 			// For cases like --xyz=42
-			option->value = nameVal.second;
-			return true;
+			return assign(nameVal.second);
 		}
 
 		// For cases like --xyz 42
@@ -198,7 +616,7 @@ namespace cmdline
 		return true;
 	}
 
-	ArgumentParseResult Parser::parseSwitch(const std::string& arg)
+	ArgumentParseResult Parser::parseSwitch(std::string_view arg)
 	{
 		if (!isOption(arg) && !isOptionAbbr(arg))
 			return false;
@@ -208,26 +626,113 @@ namespace cmdline
 		if (abbr)
 		{
 			// For cases like -x or -xyz
-			for (char c : getOptionAbbr(arg))
+			for (char c : arg.substr(1))
 			{
 				Switch* sw = this->getSwitch(c);
-				if (!sw || !sw->enabled())
-			return {false, std::string("This command does not accept \"") + arg + "\" switch"};
+				if (sw && !this->isEnabled(*sw))
+					this->recordRejected(*sw);
+				if (!sw || !this->isEnabled(*sw))
+			return {false, std::string("This command does not accept \"") + std::string(arg) + "\" switch"};
 				sw->setValue(true);
+				this->markGiven(*sw);
+				this->runAction(*sw);
 			}
 
 			return true;
 		}
 		
-		// For cases like --xyz
-		Switch *sw = this->getSwitch(getOptionName(arg));
-		if (!sw || !sw->enabled())
+		// For cases like --xyz or --no-xyz
+		std::string_view name = optionName(arg);
+		Switch *sw = this->getSwitch(name);
+		bool value = true;
+		if (!sw && name.substr(0, 3) == "no-")
+		{
+			sw = this->getSwitch(name.substr(3));
+			value = false;
+		}
+
+		if (!sw)
 			return false;
-		sw->setValue(true);
+		if (!this->isEnabled(*sw))
+		{
+			this->recordRejected(*sw);
+			return false;
+		}
+		sw->setValue(value);
+		this->markGiven(*sw);
+		if (value)
+			this->runAction(*sw);
+
+		return true;
+	}
+
+	ArgumentParseResult Parser::checkValue(const Argument& arg, std::string_view value) const
+	{
+		if (arg.constraints)
+		{
+			std::string reason = arg.constraints->check(value);
+			if (!reason.empty())
+				return { true, std::string("Invalid value \"") + std::string(value) + "\" for " + arg.name + ", " + reason };
+		}
+		return true;
+	}
+
+	ArgumentParseResult Parser::assignValue(Argument& arg, std::string_view value)
+	{
+		ArgumentParseResult res = this->checkValue(arg, value);
+		if (!res.ParseResult::operator bool())
+			return res;
 
+		if (!arg.binding)
+		{
+			arg.value.assign(value.data(), value.size());
+			return true;
+		}
+
+		if (!arg.binding.assign(arg.binding.target, value))
+			return { true, std::string("Invalid value \"") + std::string(value) + "\" for " + arg.name };
+
+		arg.binding.assigned = true;
 		return true;
 	}
 
+	ArgumentParseResult Parser::assignValue(Option& opt, std::string_view value)
+	{
+		ArgumentParseResult res = opt.fileCapable ? this->assignFile(opt, value) : this->assignValue(static_cast<Argument&>(opt), value);
+		if (!res.ParseResult::operator bool())
+			this->recordRejected(opt);
+		return res;
+	}
+
+	void Parser::setUsageRecorder(std::shared_ptr<UsageRecorder> recorder)
+	{
+		this->usage = std::move(recorder);
+		this->usageSlots.assign(this->usage ? this->optionCount : 0, nullptr);
+		if (!this->usage)
+			return;
+
+		for (const Option& opt : this->options)
+			this->usageSlots[opt.id] = &this->usage->counters(opt.name);
+		for (const Switch& sw : this->switches)
+			this->usageSlots[sw.id] = &this->usage->counters(sw.name);
+	}
+
+	void Parser::recordRejected(const Option& opt) const
+	{
+		if (this->usage && opt.id < this->usageSlots.size() && this->usageSlots[opt.id])
+			this->usageSlots[opt.id]->rejected.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void Parser::recordUsage() const
+	{
+		this->usage->recordParse();
+		for (size_t id = 0; id < this->usageSlots.size(); id++)
+		{
+			if (UsageCounters* c = this->usageSlots[id])
+				(this->states->given(id) ? c->given : c->defaulted).fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
 	Argument& Parser::addArgument(
 			const std::string& name, 
 			const std::string& value, 
@@ -240,10 +745,26 @@ namespace cmdline
 
 	Argument& Parser::addArgument(const Argument& arg)
 	{
+		CMDLINE_PHASE(Phase::schema);
+		this->frozen = false;
 		this->args.push_back(arg);
+		this->positional.push_back(&this->args.back());
 		return this->args.back();
 	}
 
+	Argument& Parser::addVariadic(
+			const std::string& name, 
+			size_t min, 
+			size_t max,
+			const std::string& description)
+	{
+		Argument& arg = this->addArgument(name, "", min ? Req::required : Req::optional, description);
+		this->variadicPos = this->positional.size() - 1;
+		this->variadicMin = min;
+		this->variadicMax = max;
+		return arg;
+	}
+
 	Option& Parser::addOption(
 			const std::string& name, 
 			char abbr, 
@@ -257,7 +778,11 @@ namespace cmdline
 
 	Option& Parser::addOption(const Option& option)
 	{
+		CMDLINE_PHASE(Phase::schema);
+		this->frozen = false;
 		this->options.push_back(option);
+		this->attach(this->options.back());
+		this->index.add(this->options.back(), ArgKind::option);
 		return this->options.back();
 	}
 
@@ -270,19 +795,87 @@ namespace cmdline
 		return this->addSwitch(Switch(name, abbr, description, enablePred));
 	}
 
+	Switch& Parser::addSwitch(
+			const std::string& name, 
+			char abbr,
+			bool& target,
+			const std::string& description,
+			ArgumentEnablePred enablePred)
+	{
+		Switch& sw = this->addSwitch(name, abbr, description, enablePred);
+		sw.bindTo(target);
+		return sw;
+	}
+
 	Switch& Parser::addSwitch(const Switch& sw)
 	{
+		CMDLINE_PHASE(Phase::schema);
+		this->frozen = false;
 		this->switches.push_back(sw);
+		this->attach(this->switches.back());
+		this->index.add(this->switches.back(), ArgKind::switch_);
 		return this->switches.back();
 	}
 
+	bool Parser::addAlias(std::string_view name, const std::string& alias)
+	{
+		CMDLINE_PHASE(Phase::schema);
+
+		ArgKind kind = ArgKind::option;
+		Option* opt = this->getOption(name);
+		if (!opt)
+		{
+			kind = ArgKind::switch_;
+			opt = this->getSwitch(name);
+		}
+
+		// Options and switches share the command line, so must aliases
+		if (!opt || this->getOption(alias) || this->getSwitch(alias))
+			return false;
+
+		this->frozen = false;
+		opt->aliases.push_back(alias);
+		return this->index.addName(*opt, kind, opt->aliases.size());
+	}
+
+	bool Parser::addAlias(std::string_view name, char abbr)
+	{
+		CMDLINE_PHASE(Phase::schema);
+
+		ArgKind kind = ArgKind::option;
+		Option* opt = this->getOption(name);
+		if (!opt)
+		{
+			kind = ArgKind::switch_;
+			opt = this->getSwitch(name);
+		}
+
+		if (!opt || abbr == NoAbbr || this->getOption(abbr) || this->getSwitch(abbr))
+			return false;
+
+		this->frozen = false;
+		opt->abbrAliases.push_back(abbr);
+		return this->index.addAbbr(*opt, kind, abbr);
+	}
+
 	void Parser::addStandardHelpSwitch()
 	{
-		this->addSwitch("help", '?', "Show help message");
+		Switch& sw = this->addSwitch("help", '?', "Show help message");
+		sw.setAction([](const Argument&) { return true; });
+		this->helpId = sw.id;
+	}
+
+	void Parser::addStandardVersionSwitch(const std::string& version)
+	{
+		Switch& sw = this->addSwitch("version", NoAbbr, "Show version");
+		sw.setAction([](const Argument&) { return true; });
+		this->versionId = sw.id;
+		this->version = version;
 	}
 
 	void Parser::addHelpSection(const HelpSection& hs)
 	{
+		CMDLINE_PHASE(Phase::schema);
 		this->helpSections.push_back(hs);
 	}
 
@@ -291,8 +884,10 @@ namespace cmdline
 		this->addHelpSection(HelpSection(name, description));
 	}
 
-	Argument* Parser::getArgument(const std::string& name)
+	Argument* Parser::getArgument(std::string_view name)
 	{
+		CMDLINE_COUNT(lookups);
+
 		for (Argument& arg : this->args)
 		{
 			if (arg.name == name)
@@ -303,16 +898,18 @@ namespace cmdline
 
 	Argument* Parser::getArgument(size_t pos)
 	{
-		if (this->args.size() <= pos)
+		CMDLINE_COUNT(lookups);
+
+		if (this->positional.size() <= pos)
 			return nullptr;
 
-		auto it = this->args.begin();
-		std::advance(it, pos);
-		return &*it;
+		return this->positional[pos];
 	}
 	
-	const Argument* Parser::getArgument(const std::string& name) const
+	const Argument* Parser::getArgument(std::string_view name) const
 	{
+		CMDLINE_COUNT(lookups);
+
 		for (const Argument& arg : this->args)
 		{
 			if (arg.name == name)
@@ -321,64 +918,86 @@ namespace cmdline
 		return nullptr;
 	}
 
-	Option* Parser::getOption(const std::string& name)
+	Option* Parser::getOption(std::string_view name)
 	{
-		for (Option& opt : this->options)
-		{
-			if (opt.name == name)
-				return &opt;
-		}
-		return nullptr;
-	}	
-		
+		CMDLINE_COUNT(lookups);
+		return this->lookup(name, ArgKind::option);
+	}
+
 	Option* Parser::getOption(const char abbr)
 	{
-		for (Option& opt : this->options)
-		{
-			if (opt.abbr == abbr)
-				return &opt;
-		}
-		return nullptr;
+		CMDLINE_COUNT(lookups);
+		return this->lookup(abbr, ArgKind::option);
 	}
 
-	const Option* Parser::getOption(const std::string& name) const
+	const Option* Parser::getOption(std::string_view name) const
 	{
-		for (const Option& opt : this->options)
-		{
-			if (opt.name == name)
-				return &opt;
-		}
-		return nullptr;
+		CMDLINE_COUNT(lookups);
+		return this->lookup(name, ArgKind::option);
 	}
 
-	Switch* Parser::getSwitch(const std::string& name)
+	const Option* Parser::getOption(const char abbr) const
 	{
-		for (Switch& sw : this->switches)
-		{
-			if (sw.name == name)
-				return &sw;
-		}
-		return nullptr;
+		CMDLINE_COUNT(lookups);
+		return this->lookup(abbr, ArgKind::option);
+	}
+
+	Switch* Parser::getSwitch(std::string_view name)
+	{
+		CMDLINE_COUNT(lookups);
+		return static_cast<Switch*>(this->lookup(name, ArgKind::switch_));
 	}
 
 	Switch* Parser::getSwitch(const char abbr)
 	{
-		for (Switch& sw : this->switches)
+		CMDLINE_COUNT(lookups);
+		return static_cast<Switch*>(this->lookup(abbr, ArgKind::switch_));
+	}
+
+	const Switch* Parser::getSwitch(std::string_view name) const
+	{
+		CMDLINE_COUNT(lookups);
+		return static_cast<const Switch*>(this->lookup(name, ArgKind::switch_));
+	}
+
+	const Switch* Parser::getSwitch(const char abbr) const
+	{
+		CMDLINE_COUNT(lookups);
+		return static_cast<const Switch*>(this->lookup(abbr, ArgKind::switch_));
+	}
+
+	// Own entries first, then the shared base parser, then the schema blob
+	Option* Parser::lookup(std::string_view name, ArgKind kind) const
+	{
+		if (this->registryPending)
+			this->loadRegistry();
+		if (Option* found = this->index.find(name, kind))
+			return found;
+		if (this->base)
 		{
-			if (sw.abbr == abbr)
-				return &sw;
+			if (Option* found = this->inherit(this->base->index.find(name, kind), kind))
+				return found;
 		}
-		return nullptr;
-	}	
-	
-	const Switch* Parser::getSwitch(const std::string& name) const
+		return static_cast<Option*>(this->materialize(this->schemaFind(name, kind)));
+	}
+
+	Option* Parser::lookup(char abbr, ArgKind kind) const
 	{
-		for (const Switch& sw : this->switches)
+		if (this->registryPending)
+			this->loadRegistry();
+		if (Option* found = this->index.find(abbr, kind))
+			return found;
+		if (this->base)
 		{
-			if (sw.name == name)
-				return &sw;
+			if (Option* found = this->inherit(this->base->index.find(abbr, kind), kind))
+				return found;
 		}
-		return nullptr;
+		return static_cast<Option*>(this->materialize(this->schemaFind(abbr, kind)));
+	}
+
+	ValueSpan Parser::getVariadic() const
+	{
+		return ValueSpan(this->variadicValues.data(), this->variadicValues.size());
 	}
 
 	std::vector<std::reference_wrapper<const Argument>> Parser::getArguments() const
@@ -386,7 +1005,7 @@ namespace cmdline
 		std::vector<std::reference_wrapper<const Argument>> result;
 		for (const Argument& arg : this->args)
 		{
-			if (arg.enabled())
+			if (this->isEnabled(arg))
 				result.push_back(arg);
 		}
 		return result;
@@ -394,10 +1013,12 @@ namespace cmdline
 	
 	std::vector<std::reference_wrapper<const Option>> Parser::getOptions() const
 	{
+		this->materializeAll();
+
 		std::vector<std::reference_wrapper<const Option>> result;
 		for (const Option& opt : this->options)
 		{
-			if (opt.enabled())
+			if (this->isEnabled(opt))
 				result.push_back(opt);
 		}
 		return result;
@@ -405,10 +1026,12 @@ namespace cmdline
 	
 	std::vector<std::reference_wrapper<const Switch>> Parser::getSwitches() const
 	{
+		this->materializeAll();
+
 		std::vector<std::reference_wrapper<const Switch>> result;
 		for (const Switch& sw : this->switches)
 		{
-			if (sw.enabled())
+			if (this->isEnabled(sw))
 				result.push_back(sw);
 		}
 		return result;
@@ -416,40 +1039,62 @@ namespace cmdline
 
 	ArgumentParseResult Parser::validateArguments() const
 	{
+		CMDLINE_PHASE(Phase::validate);
 		for (const Argument& arg : this->args)
 		{
-			if (!arg.enabled())
+			if (!this->isEnabled(arg))
 				continue;
 
 			if (
 				arg.required == Req::required &&
-				arg.value.empty()
+				!arg.hasValue()
 			)
 				return { false, std::string("Positional argument ") + arg.name + " is required" };
 		}
 
+		if (this->variadicPos != NoId && this->variadicValues.size() < this->variadicMin)
+		{
+			const Argument& arg = *this->positional[this->variadicPos];
+			if (this->isEnabled(arg))
+				return { false, std::string("Positional argument ") + arg.name + " requires at least " + std::to_string(this->variadicMin) + " values" };
+		}
+
 		return true;
 	}
 
 	ArgumentParseResult Parser::validateOptions() const
 	{
+		CMDLINE_PHASE(Phase::validate);
 		for (const Option& opt : this->options)
 		{
-			if (!opt.enabled())
+			if (!this->isEnabled(opt))
 				continue;
 
 			if (
 				opt.required == Req::required &&
-				opt.value.empty()
+				!opt.hasValue()
 			)
 				return { false, std::string("Option ") + opt.name + " is required" };
 		}
 
+		// Entries of the base parser and the schema blob that were never looked
+		// up keep their defaults
+		for (const Option* opt : this->baseRequired)
+		{
+			if (!this->inherited[opt->id] && this->isEnabled(*opt) && !opt->hasValue())
+				return { false, std::string("Option ") + opt->name + " is required" };
+		}
+
+		std::string missing;
+		if (this->schemaRequiresMissing(missing))
+			return { false, std::string("Option ") + missing + " is required" };
+
 		return true;
 	}
 
 	ParseResult Parser::validateCommand() const
 	{
+		CMDLINE_PHASE(Phase::validate);
 		ParseResult res;
 
 		bool hasOptional = false;
@@ -462,23 +1107,287 @@ namespace cmdline
 				res.merge({{"Positional argument \"" + arg.name + "\" cannot be optional"}});
 		}
 
+		if (this->variadicPos != NoId && this->variadicPos + 1 != this->positional.size())
+			res.merge({{"Variadic argument \"" + this->positional[this->variadicPos]->name + "\" must be the last positional argument"}});
+
+		for (const OptionGroup& group : this->groups)
+		{
+			for (const std::string& name : group.unknown)
+				res.merge({{"Option group references unknown option \"" + name + "\""}});
+		}
+
 		return res;
 	}
 
-	bool Parser::isOption(const std::string& arg)
+	ParseResult Parser::freeze()
+	{
+		CMDLINE_PHASE(Phase::validate);
+
+		this->frozen = false;
+		this->materializeAll();
+
+		ParseResult res = this->validateCommand();
+
+		for (const Argument& arg : this->args)
+		{
+			if (this->getArgument(std::string_view(arg.name)) != &arg)
+				res.merge({{"Positional argument \"" + arg.name + "\" is defined more than once"}});
+		}
+
+		// The index keeps the first definition of every spelling, any other
+		// entry using it is never found. Options are looked up before switches.
+		auto checkEntry = [this, &res](const Option& opt, ArgKind kind) {
+			auto checkName = [this, &res, &opt, kind](const std::string& name) {
+				if (this->index.find(name, kind) != &opt)
+					res.merge({{"\"--" + name + "\" is defined more than once"}});
+				else if (kind == ArgKind::switch_ && this->index.find(name, ArgKind::option))
+					res.merge({{"\"--" + name + "\" is both an option and a switch"}});
+			};
+			auto checkAbbr = [this, &res, &opt, kind](char abbr) {
+				if (this->index.find(abbr, kind) != &opt)
+					res.merge({{std::string("\"-") + abbr + "\" is defined more than once"}});
+				else if (kind == ArgKind::switch_ && this->index.find(abbr, ArgKind::option))
+					res.merge({{std::string("\"-") + abbr + "\" is both an option and a switch"}});
+			};
+
+			checkName(opt.name);
+			for (const std::string& alias : opt.aliases)
+				checkName(alias);
+			if (opt.abbr != NoAbbr)
+				checkAbbr(opt.abbr);
+			for (char abbr : opt.abbrAliases)
+				checkAbbr(abbr);
+		};
+		for (const Option& opt : this->options)
+			checkEntry(opt, ArgKind::option);
+		for (const Switch& sw : this->switches)
+			checkEntry(sw, ArgKind::switch_);
+
+		// Evaluate every predicate once to see which switches it reads
+		std::vector<bool> switchIds(this->optionCount, false);
+		for (const Switch& sw : this->switches)
+			switchIds[sw.id] = true;
+
+		std::vector<std::pair<uint64_t, size_t>> probed;
+		auto checkPred = [this, &res, &probed, &switchIds](const Argument& arg) {
+			if (!arg.enablePred)
+				return;
+
+			probed.clear();
+			probedSwitches = &probed;
+			this->isEnabled(arg);
+			probedSwitches = nullptr;
+
+			for (const auto& read : probed)
+			{
+				if (read.first != this->states->getOrigin() || read.second >= switchIds.size() || !switchIds[read.second])
+				{
+					res.merge({{"\"" + arg.name + "\" depends on a switch unknown to this parser"}});
+					break;
+				}
+			}
+		};
+		for (const Argument& arg : this->args)
+			checkPred(arg);
+		for (const Option& opt : this->options)
+			checkPred(opt);
+		for (const Switch& sw : this->switches)
+			checkPred(sw);
+
+		this->frozen = static_cast<bool>(res);
+		return res;
+	}
+
+	Parser::Parser(std::shared_ptr<const Parser> base)
+		: Parser(false)
+	{
+		// Entries are copied from the base on lookup, so it must be complete
+		base->materializeAll();
+
+		this->cmdname = base->cmdname;
+		this->frozen = base->frozen;
+		this->schema = base->schema;
+		this->materialized = base->materialized;
+		this->schemaSectionBase = base->schemaSectionBase;
+		this->helpSections = base->helpSections;
+		this->groups = base->groups;
+		this->optionCount = base->optionCount;
+		this->states = std::make_unique<ArgumentStates>(*base->states);
+		this->helpId = base->helpId;
+		this->versionId = base->versionId;
+		this->version = base->version;
+		this->autohelp = base->autohelp;
+		this->helpMaxWidth = base->helpMaxWidth;
+		this->helpMaxArgWidth = base->helpMaxArgWidth;
+		this->helpPred = base->helpPred;
+		this->descriptionProvider = base->descriptionProvider;
+		this->usage = base->usage;
+		this->usageSlots = base->usageSlots;
+		this->changeCallbacks = base->changeCallbacks;
+
+		// Positional arguments are few, they're copied right away
+		for (const Argument& arg : base->args)
+		{
+			this->args.push_back(arg);
+			this->positional.push_back(&this->args.back());
+			this->rebindSection(this->args.back(), *base);
+		}
+		this->variadicPos = base->variadicPos;
+		this->variadicMin = base->variadicMin;
+		this->variadicMax = base->variadicMax;
+
+		this->base = std::move(base);
+		this->inherited.assign(this->optionCount, false);
+		for (const Option& opt : this->base->options)
+		{
+			if (opt.required == Req::required)
+				this->baseRequired.push_back(&opt);
+		}
+	}
+
+	Option* Parser::inherit(const Option* entry, ArgKind kind) const
+	{
+		if (!entry || entry->id >= this->inherited.size() || this->inherited[entry->id])
+			return nullptr;
+
+		Option* opt;
+		if (kind == ArgKind::switch_)
+		{
+			// The state is already in the copied bitsets
+			this->switches.push_back(static_cast<const Switch&>(*entry));
+			this->switches.back().states = this->states.get();
+			opt = &this->switches.back();
+		}
+		else
+		{
+			this->options.push_back(*entry);
+			opt = &this->options.back();
+		}
+
+		this->rebindSection(*opt, *this->base);
+		this->index.add(*opt, kind);
+		this->inherited[opt->id] = true;
+		return opt;
+	}
+
+	void Parser::inheritAll() const
+	{
+		if (!this->base)
+			return;
+
+		bool created = false;
+		for (const Option& opt : this->base->options)
+			created |= this->inherit(&opt, ArgKind::option) != nullptr;
+		for (const Switch& sw : this->base->switches)
+			created |= this->inherit(&sw, ArgKind::switch_) != nullptr;
+
+		if (!created)
+			return;
+
+		// Restore the base order, entries added to this parser go last
+		std::vector<size_t> order(this->inherited.size());
+		size_t pos = 0;
+		for (const Option& opt : this->base->options)
+			order[opt.id] = pos++;
+		for (const Switch& sw : this->base->switches)
+			order[sw.id] = pos++;
+
+		auto byBase = [&order](const Option& a, const Option& b) {
+			size_t ia = a.id < order.size() ? order[a.id] : order.size() + a.id;
+			size_t ib = b.id < order.size() ? order[b.id] : order.size() + b.id;
+			return ia < ib;
+		};
+		this->options.sort(byBase);
+		this->switches.sort(byBase);
+	}
+
+	void Parser::rebindSection(Argument& arg, const Parser& from) const
+	{
+		if (!from.helpSections.empty() && arg.helpSection >= &from.helpSections.front() && arg.helpSection <= &from.helpSections.back())
+			arg.helpSection = const_cast<HelpSection*>(&this->helpSections[arg.helpSection - &from.helpSections.front()]);
+	}
+
+	void Parser::attach(Option& opt) const
+	{
+		opt.id = this->optionCount++;
+		this->states->resize(this->optionCount);
+
+		if (this->usage)
+		{
+			this->usageSlots.resize(this->optionCount, nullptr);
+			this->usageSlots[opt.id] = &this->usage->counters(opt.name);
+		}
+	}
+
+	void Parser::attach(Switch& sw) const
+	{
+		// Carry over the state of a standalone switch
+		bool on = sw.on();
+		sw.value.clear();
+
+		this->attach(static_cast<Option&>(sw));
+		sw.states = this->states.get();
+		sw.setValue(on);
+	}
+
+	void Parser::markGiven(const Option& opt)
+	{
+		this->states->setGiven(opt.id);
+	}
+
+	void Parser::runAction(const Argument& arg)
+	{
+		if (arg.action && !this->stopper && arg.action(arg))
+			this->stopper = &arg;
+	}
+
+	bool Parser::isGiven(const Option& opt) const
+	{
+		return this->states->given(opt.id);
+	}
+
+	const ArgumentStates& Parser::getStates() const
+	{
+		return *this->states;
+	}
+
+	bool Parser::isEnabled(const Argument& arg) const
+	{
+		CMDLINE_COUNT(predicateEvaluations);
+
+		const ArgumentStates* previous = evaluatingStates;
+		evaluatingStates = this->states.get();
+		bool enabled = arg.enabled();
+		evaluatingStates = previous;
+		return enabled;
+	}
+
+	const ParserStats& Parser::getStats() const
+	{
+		return this->stats;
+	}
+
+	void Parser::resetStats()
+	{
+		this->stats = {};
+#ifdef LIBCMDLINE_INSTRUMENTATION
+		this->statsEpoch = std::chrono::steady_clock::now();
+#endif
+	}
+
+	bool Parser::isOption(std::string_view arg)
 	{
 		return arg.size() > 2 && arg[0] == '-' && arg[1] == '-';
 	}
 	
-	bool Parser::isOptionAbbr(const std::string& arg)
+	bool Parser::isOptionAbbr(std::string_view arg)
 	{
 		return arg.size() > 1 && !isOption(arg) && arg.front() == '-';
 	}
 
 	std::string Parser::getOptionName(const std::string& arg)
 	{
-		size_t equals = arg.find_first_of('=');
-		return arg.substr(2, equals - 2);
+		return std::string(optionName(arg));
 	}
 
 	std::string Parser::getOptionAbbr(const std::string& arg)
@@ -488,24 +1397,28 @@ namespace cmdline
 
 	std::pair<std::string, std::string> Parser::getNameEqualsValue(const std::string& arg)
 	{
-		size_t eqpos = arg.find_first_of('=');
-		if (eqpos == std::string::npos)
-			return {};
-		std::string name = getOptionName(arg.substr(0, eqpos));
-		std::string val = arg.substr(eqpos + 1);
-		return { std::move(name), std::move(val) };
+		auto nameVal = nameEqualsValue(arg);
+		return { std::string(nameVal.first), std::string(nameVal.second) };
 	}
 
 	std::string Parser::getArgRepresentation(const Argument& arg)
 	{
-		if (const Option* opt = dynamic_cast<const Option*>(&arg))
+		if (arg.kind != ArgKind::argument)
 		{
+			const Option* opt = static_cast<const Option*>(&arg);
 			std::string res = "--" + opt->name;
 			if (opt->abbr)
 			{
 				res += ", -";
 				res.push_back(opt->abbr);
 			}
+			for (const std::string& alias : opt->aliases)
+				res += ", --" + alias;
+			for (char abbr : opt->abbrAliases)
+			{
+				res += ", -";
+				res.push_back(abbr);
+			}
 
 			if (opt->expectsValue())
 				res += " [value]";
@@ -516,13 +1429,30 @@ namespace cmdline
 		return arg.name;
 	}
 	
+	std::string Parser::getArgDescription(const Argument& arg)
+	{
+		if (!arg.constraints || arg.constraints->getChoices().empty())
+			return arg.description;
+
+		std::string res = arg.description;
+		if (!res.empty())
+			res += " ";
+
+		const auto& choices = arg.constraints->getChoices();
+		res += "(one of:";
+		for (size_t i = 0; i < choices.size(); i++)
+			res += (i ? ", " : " ") + choices[i];
+		res += ")";
+		return res;
+	}
+
 	size_t Parser::getNameLength(const std::vector<std::reference_wrapper<const Argument>>& args) const
 	{
 		size_t result = 0;
 
 		for (const Argument& arg : args)
 		{
-			size_t width = getArgRepresentation(arg).length();
+			size_t width = displayWidth(getArgRepresentation(arg));
 			if (width <= this->helpMaxArgWidth && width > result)
 					result = width;
 		}
@@ -544,72 +1474,4 @@ namespace cmdline
 	{
 		this->helpPred = staticHelp(help);
 	}
-
-	std::string Parser::getHelp() const
-	{
-		std::string result;
-
-		if (this->helpPred)
-			result += this->helpPred() + "\n\n";
-
-		result += "Usage:\n\n";
-
-		auto args = this->getArguments();
-		auto opts = this->getOptions();
-		auto switches = this->getSwitches();
-
-		result += "  " + this->cmdname + " [Options]";
-		for (const auto& arg : args)
-			result += " <" + arg.get().name + ">";
-		result += "\n";
-
-		auto section = [this](const std::vector<std::reference_wrapper<const Argument>>& args, const std::string& name = ""){
-			size_t widest = getNameLength(args);
-
-			std::stringstream str;
-
-			if (!name.empty())
-				str << name << ":\n";
-
-			str << std::setiosflags(std::ios::left);
-			for (const Argument& arg : args)
-			{
-				auto name = getArgRepresentation(arg);
-
-				size_t width = name.length();
-				std::string indent(2, ' ');
-				if (width > widest)
-				{
-					str << indent << name << "\n";
-					str << indent << std::setw(widest) << " ";
-				}
-				else
-				{
-					str << indent << std::setw(widest) << name;
-				}
-
-				if (!arg.description.empty())
-				{
-					str << " = ";
-					str << arg.description << "\n";
-				}
-				else
-					str << "\n";
-			}
-
-			return str.str();
-		};
-
-		if (!args.empty())
-			result += "\n" + section(args, "Arguments");
-
-		std::vector<std::reference_wrapper<const Argument>> allOptions;
-		allOptions.insert(allOptions.end(), opts.begin(), opts.end());
-		allOptions.insert(allOptions.end(), switches.begin(), switches.end());
-
-		if (!allOptions.empty())
-			result += "\n" + section(allOptions, "Options");
-
-		return result;
-	}
 }
@@ -0,0 +1,63 @@
+#include "libcmdline/constraints.h"
+
+#include <charconv>
+#include <sstream>
+
+namespace cmdline
+{
+	void ValueConstraints::setRange(double min, double max)
+	{
+		this->range = std::make_pair(min, max);
+	}
+
+	void ValueConstraints::setChoices(const std::vector<std::string>& choices)
+	{
+		this->choiceIndex.clear();
+		this->choices = choices;
+
+		// Views stay valid, choices isn't modified after this point
+		this->choiceIndex.reserve(this->choices.size());
+		for (const std::string& choice : this->choices)
+			this->choiceIndex.insert(choice);
+	}
+
+	void ValueConstraints::setPattern(const std::string& pattern)
+	{
+		this->pattern.emplace(pattern, std::regex::ECMAScript | std::regex::optimize);
+		this->patternSource = pattern;
+	}
+
+	std::string ValueConstraints::check(std::string_view value) const
+	{
+		if (!this->choices.empty() && !this->choiceIndex.count(value))
+		{
+			std::string res = "must be one of";
+			for (size_t i = 0; i < this->choices.size(); i++)
+				res += (i ? ", " : " ") + this->choices[i];
+			return res;
+		}
+
+		if (this->range)
+		{
+			double num;
+			const char* end = value.data() + value.size();
+			auto res = std::from_chars(value.data(), end, num);
+			if (res.ec != std::errc() || res.ptr != end || num < this->range->first || num > this->range->second)
+			{
+				std::stringstream str;
+				str << "must be a number between " << this->range->first << " and " << this->range->second;
+				return str.str();
+			}
+		}
+
+		if (this->pattern && !std::regex_match(value.begin(), value.end(), *this->pattern))
+			return "must match " + this->patternSource;
+
+		return {};
+	}
+
+	const std::vector<std::string>& ValueConstraints::getChoices() const
+	{
+		return this->choices;
+	}
+}
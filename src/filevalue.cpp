@@ -0,0 +1,129 @@
+#include "libcmdline/filevalue.h"
+#include "libcmdline/cmdline.h"
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cmdline
+{
+	FileValue::FileValue(const std::string& path)
+		: filePath(path)
+	{ }
+
+	FileValue::~FileValue()
+	{
+#ifndef _WIN32
+		if (this->mapping)
+			munmap(this->mapping, this->mappingLength);
+#endif
+	}
+
+	const std::string& FileValue::path() const
+	{
+		return this->filePath;
+	}
+
+	std::string_view FileValue::contents() const
+	{
+		std::call_once(this->loaded, [this]() { this->load(); });
+		return this->data;
+	}
+
+	const std::string& FileValue::error() const
+	{
+		std::call_once(this->loaded, [this]() { this->load(); });
+		return this->loadError;
+	}
+
+	void FileValue::load() const
+	{
+#ifdef _WIN32
+		std::ifstream file(this->filePath, std::ios::binary);
+		if (!file)
+		{
+			this->loadError = "Cannot open file " + this->filePath;
+			return;
+		}
+		this->storage.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		this->data = this->storage;
+#else
+		int fd = ::open(this->filePath.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			this->loadError = "Cannot open file " + this->filePath;
+			return;
+		}
+
+		struct stat st;
+		if (fstat(fd, &st) != 0)
+		{
+			::close(fd);
+			this->loadError = "Cannot read file " + this->filePath;
+			return;
+		}
+
+		// Empty files can't be mapped
+		if (st.st_size > 0)
+		{
+			void* mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapping == MAP_FAILED)
+				this->loadError = "Cannot map file " + this->filePath;
+			else
+			{
+				this->mapping = mapping;
+				this->mappingLength = static_cast<size_t>(st.st_size);
+				this->data = std::string_view(static_cast<const char*>(mapping), this->mappingLength);
+			}
+		}
+		::close(fd);
+#endif
+	}
+
+	std::string_view Option::contents() const
+	{
+		if (this->file)
+			return this->file->contents();
+		return this->value;
+	}
+
+	ArgumentParseResult Parser::assignFile(Option& opt, std::string_view value)
+	{
+		opt.file = nullptr;
+
+		// @@ escapes values starting with @
+		if (value.substr(0, 2) == "@@")
+			return this->assignValue(static_cast<Argument&>(opt), value.substr(1));
+		if (value.empty() || value[0] != '@')
+			return this->assignValue(static_cast<Argument&>(opt), value);
+
+		auto file = std::make_shared<FileValue>(std::string(value.substr(1)));
+		ArgumentParseResult res = true;
+
+		// Bound and constrained values need the contents right away
+		if (opt.binding || opt.constraints)
+		{
+			std::string_view contents = file->contents();
+			if (!file->error().empty())
+				return { true, file->error() + " given for " + opt.name };
+
+			res = this->assignValue(static_cast<Argument&>(opt), contents);
+			if (!res.ParseResult::operator bool())
+				return res;
+		}
+
+		if (!opt.binding)
+			opt.value.assign(value.data(), value.size());
+		opt.file = file;
+
+		// The parse result shares the mapping
+		res.keep(std::move(file));
+		return res;
+	}
+}
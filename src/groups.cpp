@@ -0,0 +1,132 @@
+#include "libcmdline/cmdline.h"
+#include "instrumentation.h"
+
+#include <bitset>
+
+namespace cmdline
+{
+	namespace
+	{
+		void setBit(std::vector<uint64_t>& bits, size_t i)
+		{
+			if (bits.size() <= i / 64)
+				bits.resize(i / 64 + 1, 0);
+			bits[i / 64] |= uint64_t(1) << (i % 64);
+		}
+
+		// Number of bits set in both a and b
+		size_t countCommon(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b)
+		{
+			size_t n = 0;
+			for (size_t i = 0; i < a.size() && i < b.size(); i++)
+				n += std::bitset<64>(a[i] & b[i]).count();
+			return n;
+		}
+
+		size_t count(const std::vector<uint64_t>& a)
+		{
+			return countCommon(a, a);
+		}
+
+		std::string joinNames(const std::vector<std::string>& names, size_t first = 0)
+		{
+			std::string res;
+			for (size_t i = first; i < names.size(); i++)
+				res += (i > first ? ", --" : "--") + names[i];
+			return res;
+		}
+	}
+
+	OptionGroup& Parser::addGroup(OptionGroup::Kind kind, const std::vector<std::string>& names)
+	{
+		OptionGroup group;
+		group.kind = kind;
+		group.names = names;
+
+		for (const std::string& name : names)
+		{
+			const Option* opt = this->getOption(name);
+			if (!opt)
+				opt = this->getSwitch(name);
+
+			if (opt)
+				setBit(group.mask, opt->id);
+			else
+				group.unknown.push_back(name);
+		}
+
+		this->frozen = false;
+		this->groups.push_back(std::move(group));
+		return this->groups.back();
+	}
+
+	void Parser::addExclusiveGroup(const std::vector<std::string>& names, Req required)
+	{
+		this->addGroup(OptionGroup::Kind::exclusive, names).required = required;
+	}
+
+	void Parser::addAtLeastOneGroup(const std::vector<std::string>& names)
+	{
+		this->addGroup(OptionGroup::Kind::atLeastOne, names);
+	}
+
+	void Parser::addAllOrNoneGroup(const std::vector<std::string>& names)
+	{
+		this->addGroup(OptionGroup::Kind::allOrNone, names);
+	}
+
+	void Parser::addRequirement(const std::string& name, const std::vector<std::string>& required)
+	{
+		std::vector<std::string> names { name };
+		names.insert(names.end(), required.begin(), required.end());
+
+		OptionGroup& group = this->addGroup(OptionGroup::Kind::dependency, names);
+
+		// The trigger is kept out of the mask of required options
+		const Option* opt = this->getOption(name);
+		if (!opt)
+			opt = this->getSwitch(name);
+		if (opt)
+		{
+			setBit(group.trigger, opt->id);
+			group.mask[opt->id / 64] &= ~(uint64_t(1) << (opt->id % 64));
+		}
+	}
+
+	ArgumentParseResult Parser::validateGroups() const
+	{
+		CMDLINE_PHASE(Phase::validate);
+
+		for (const OptionGroup& group : this->groups)
+		{
+			size_t given = countCommon(this->states->getGiven(), group.mask);
+
+			switch (group.kind)
+			{
+			case OptionGroup::Kind::exclusive:
+				if (given > 1)
+					return { false, "Options " + joinNames(group.names) + " are mutually exclusive" };
+				if (given == 0 && group.required == Req::required)
+					return { false, "One of " + joinNames(group.names) + " is required" };
+				break;
+
+			case OptionGroup::Kind::atLeastOne:
+				if (given == 0)
+					return { false, "At least one of " + joinNames(group.names) + " is required" };
+				break;
+
+			case OptionGroup::Kind::allOrNone:
+				if (given != 0 && given != count(group.mask))
+					return { false, "Options " + joinNames(group.names) + " must be given together" };
+				break;
+
+			case OptionGroup::Kind::dependency:
+				if (countCommon(this->states->getGiven(), group.trigger) && given != count(group.mask))
+					return { false, "Option --" + group.names.front() + " requires " + joinNames(group.names, 1) };
+				break;
+			}
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,25 @@
+#ifndef _h_libcmdline_hash
+#define _h_libcmdline_hash
+
+#include <cstdint>
+#include <string_view>
+
+namespace cmdline
+{
+	namespace detail
+	{
+		// FNV-1a, used by the lookup index and stored in schema blobs
+		inline uint32_t hashName(std::string_view name)
+		{
+			uint32_t h = 2166136261u;
+			for (char c : name)
+			{
+				h ^= static_cast<unsigned char>(c);
+				h *= 16777619u;
+			}
+			return h;
+		}
+	}
+}
+
+#endif
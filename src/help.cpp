@@ -0,0 +1,312 @@
+#include "libcmdline/cmdline.h"
+#include "libcmdline/width.h"
+#include "libcmdline/schema.h"
+#include "helpoutput.h"
+#include "instrumentation.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ostream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace cmdline
+{
+	namespace detail
+	{
+		HelpOutput::HelpOutput(Sink sink, void* target)
+			: sink(sink)
+			, target(target)
+		{ }
+
+		void HelpOutput::write(std::string_view str)
+		{
+			while (!str.empty())
+			{
+				if (this->used == sizeof(this->buffer))
+					this->flush();
+
+				size_t n = std::min(str.size(), sizeof(this->buffer) - this->used);
+				std::memcpy(this->buffer + this->used, str.data(), n);
+				this->used += n;
+				str.remove_prefix(n);
+			}
+		}
+
+		void HelpOutput::write(char c)
+		{
+			if (this->used == sizeof(this->buffer))
+				this->flush();
+			this->buffer[this->used++] = c;
+		}
+
+		void HelpOutput::fill(char c, size_t count)
+		{
+			while (count)
+			{
+				if (this->used == sizeof(this->buffer))
+					this->flush();
+
+				size_t n = std::min(count, sizeof(this->buffer) - this->used);
+				std::memset(this->buffer + this->used, c, n);
+				this->used += n;
+				count -= n;
+			}
+		}
+
+		bool HelpOutput::flush()
+		{
+			if (this->used && this->ok)
+				this->ok = this->sink(this->target, this->buffer, this->used);
+			this->used = 0;
+			return this->ok;
+		}
+	}
+
+	namespace
+	{
+		bool isOptionEntry(const Argument& arg)
+		{
+			return arg.kind != ArgKind::argument;
+		}
+
+		// Counterparts of Parser::getArgRepresentation and getArgDescription
+		// writing the pieces instead of building strings
+		size_t representationWidth(const Argument& arg)
+		{
+			if (!isOptionEntry(arg))
+				return displayWidth(arg.name);
+
+			const Option& opt = static_cast<const Option&>(arg);
+			size_t width = 2 + displayWidth(opt.name) + (opt.abbr ? 4 : 0) + (opt.expectsValue() ? 8 : 0);
+			for (const std::string& alias : opt.aliases)
+				width += 4 + displayWidth(alias);
+			return width + 4 * opt.abbrAliases.size();
+		}
+
+		void writeRepresentation(detail::HelpOutput& out, const Argument& arg)
+		{
+			if (!isOptionEntry(arg))
+			{
+				out.write(arg.name);
+				return;
+			}
+
+			const Option& opt = static_cast<const Option&>(arg);
+			out.write("--");
+			out.write(opt.name);
+			if (opt.abbr)
+			{
+				out.write(", -");
+				out.write(opt.abbr);
+			}
+			for (const std::string& alias : opt.aliases)
+			{
+				out.write(", --");
+				out.write(alias);
+			}
+			for (char abbr : opt.abbrAliases)
+			{
+				out.write(", -");
+				out.write(abbr);
+			}
+			if (opt.expectsValue())
+				out.write(" [value]");
+		}
+
+		bool hasChoices(const Argument& arg)
+		{
+			return arg.constraints && !arg.constraints->getChoices().empty();
+		}
+
+		void writeDescription(detail::HelpOutput& out, const Argument& arg, const std::string& description)
+		{
+			out.write(description);
+			if (!hasChoices(arg))
+				return;
+
+			if (!description.empty())
+				out.write(' ');
+
+			const auto& choices = arg.constraints->getChoices();
+			out.write("(one of:");
+			for (size_t i = 0; i < choices.size(); i++)
+			{
+				out.write(i ? ", " : " ");
+				out.write(choices[i]);
+			}
+			out.write(')');
+		}
+	}
+
+	void Parser::writeHelp(detail::HelpOutput& out) const
+	{
+		CMDLINE_PHASE(Phase::help);
+		this->materializeAll();
+
+		if (this->helpPred)
+		{
+			out.write(this->helpPred());
+			out.write("\n\n");
+		}
+
+		out.write("Usage:\n\n");
+
+		out.write("  ");
+		out.write(this->cmdname);
+		out.write(" [Options]");
+		for (size_t i = 0; i < this->positional.size(); i++)
+		{
+			out.write(" <");
+			out.write(this->positional[i]->name);
+			out.write(i == this->variadicPos ? ">..." : ">");
+		}
+		out.write('\n');
+
+		auto section = [this, &out](const char* name, const auto& forEach) {
+			size_t widest = 0;
+			forEach([this, &widest](const Argument& arg) {
+				size_t width = representationWidth(arg);
+				if (width <= this->helpMaxArgWidth && width > widest)
+					widest = width;
+			});
+
+			out.write('\n');
+			out.write(name);
+			out.write(":\n");
+
+			// Padded by display width rather than bytes
+			forEach([this, &out, widest](const Argument& arg) {
+				size_t width = representationWidth(arg);
+				out.write("  ");
+				writeRepresentation(out, arg);
+				if (width > widest)
+				{
+					out.write("\n  ");
+					out.fill(' ', std::max<size_t>(widest, 1));
+				}
+				else
+					out.fill(' ', widest - width);
+
+				std::string description = this->getDescription(arg);
+				if (!description.empty() || hasChoices(arg))
+				{
+					out.write(" = ");
+					writeDescription(out, arg, description);
+				}
+				out.write('\n');
+			});
+		};
+
+		if (!this->args.empty())
+		{
+			section("Arguments", [this](const auto& f) {
+				for (const Argument& arg : this->args)
+					f(arg);
+			});
+		}
+
+		if (!this->options.empty() || !this->switches.empty())
+		{
+			section("Options", [this](const auto& f) {
+				for (const Option& opt : this->options)
+					f(opt);
+				for (const Switch& sw : this->switches)
+					f(sw);
+			});
+		}
+
+		out.flush();
+	}
+
+	void Parser::setDescriptionProvider(DescriptionProvider provider)
+	{
+		this->descriptionProvider = provider;
+	}
+
+	std::string Parser::getDescription(const Argument& arg) const
+	{
+		if (!arg.description.empty())
+			return arg.description;
+
+		if (this->descriptionProvider)
+		{
+			std::string description = this->descriptionProvider(arg);
+			if (!description.empty())
+				return description;
+		}
+
+		// Entries created from a schema blob leave their description in it
+		if (this->schema)
+		{
+			size_t i = this->schema->find(arg.name, arg.kind);
+			if (i != SchemaBlob::npos)
+				return std::string(this->schema->entry(i).description);
+		}
+
+		return {};
+	}
+
+	std::string Parser::getHelp() const
+	{
+		std::string result;
+		detail::HelpOutput out([](void* target, const char* data, size_t size) {
+			static_cast<std::string*>(target)->append(data, size);
+			return true;
+		}, &result);
+
+		this->writeHelp(out);
+		return result;
+	}
+
+	bool Parser::writeHelp(std::ostream& stream) const
+	{
+		detail::HelpOutput out([](void* target, const char* data, size_t size) {
+			auto& os = *static_cast<std::ostream*>(target);
+			os.write(data, static_cast<std::streamsize>(size));
+			return !os.fail();
+		}, &stream);
+
+		this->writeHelp(out);
+		return out.flush();
+	}
+
+	bool Parser::writeHelp(std::FILE* file) const
+	{
+		detail::HelpOutput out([](void* target, const char* data, size_t size) {
+			return std::fwrite(data, 1, size, static_cast<std::FILE*>(target)) == size;
+		}, file);
+
+		this->writeHelp(out);
+		return out.flush();
+	}
+
+	bool Parser::writeHelp(int fd) const
+	{
+		detail::HelpOutput out([](void* target, const char* data, size_t size) {
+			int fd = *static_cast<int*>(target);
+			while (size)
+			{
+#ifdef _WIN32
+				int n = _write(fd, data, static_cast<unsigned>(size));
+#else
+				ssize_t n = ::write(fd, data, size);
+#endif
+				if (n < 0 && errno == EINTR)
+					continue;
+				if (n <= 0)
+					return false;
+				data += n;
+				size -= static_cast<size_t>(n);
+			}
+			return true;
+		}, &fd);
+
+		this->writeHelp(out);
+		return out.flush();
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef _h_libcmdline_helpoutput
+#define _h_libcmdline_helpoutput
+
+#include <cstddef>
+#include <string_view>
+
+namespace cmdline
+{
+	namespace detail
+	{
+		// Fixed size buffer passed to a sink function whenever it fills up
+		class HelpOutput
+		{
+		public:
+			using Sink = bool (*)(void* target, const char* data, size_t size);
+
+			HelpOutput(Sink sink, void* target);
+
+			HelpOutput(const HelpOutput&) = delete;
+			HelpOutput& operator=(const HelpOutput&) = delete;
+
+			void write(std::string_view str);
+			void write(char c);
+			void fill(char c, size_t count);
+
+			// Pass buffered data to the sink, false if the sink failed so far
+			bool flush();
+
+		protected:
+			char buffer[4096];
+			size_t used = 0;
+			Sink sink;
+			void* target;
+			bool ok = true;
+		};
+	}
+}
+
+#endif
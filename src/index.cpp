@@ -0,0 +1,115 @@
+#include "libcmdline/cmdline.h"
+#include "hash.h"
+
+namespace cmdline
+{
+	namespace
+	{
+		size_t abbrSlot(char abbr, ArgKind kind)
+		{
+			return (kind == ArgKind::option ? 0 : 256) + static_cast<unsigned char>(abbr);
+		}
+
+		const std::string& nameOf(const Option& entry, uint32_t nameIndex)
+		{
+			return nameIndex ? entry.aliases[nameIndex - 1] : entry.name;
+		}
+	}
+
+	void LookupIndex::clear()
+	{
+		this->hashes.clear();
+		this->kinds.clear();
+		this->entries.clear();
+		this->names.clear();
+		this->slots.clear();
+		std::fill(this->abbrs.begin(), this->abbrs.end(), nullptr);
+	}
+
+	void LookupIndex::add(Option& entry, ArgKind kind)
+	{
+		// First definition of a name or abbreviation wins
+		this->addName(entry, kind, 0);
+		for (size_t i = 0; i < entry.aliases.size(); i++)
+			this->addName(entry, kind, i + 1);
+
+		this->addAbbr(entry, kind, entry.abbr);
+		for (char abbr : entry.abbrAliases)
+			this->addAbbr(entry, kind, abbr);
+	}
+
+	bool LookupIndex::addName(Option& entry, ArgKind kind, size_t nameIndex)
+	{
+		const std::string& name = nameOf(entry, static_cast<uint32_t>(nameIndex));
+		if (this->find(name, kind) != nullptr)
+			return false;
+
+		uint32_t record = static_cast<uint32_t>(this->entries.size());
+		this->hashes.push_back(detail::hashName(name));
+		this->kinds.push_back(kind);
+		this->entries.push_back(&entry);
+		this->names.push_back(static_cast<uint32_t>(nameIndex));
+
+		if (this->slots.size() < this->entries.size() * 2)
+			this->rehash(std::max<size_t>(16, this->slots.size() * 2));
+		else
+		{
+			size_t mask = this->slots.size() - 1;
+			size_t slot = this->hashes.back() & mask;
+			while (this->slots[slot])
+				slot = (slot + 1) & mask;
+			this->slots[slot] = record + 1;
+		}
+
+		return true;
+	}
+
+	bool LookupIndex::addAbbr(Option& entry, ArgKind kind, char abbr)
+	{
+		if (abbr == NoAbbr || this->abbrs[abbrSlot(abbr, kind)])
+			return false;
+
+		this->abbrs[abbrSlot(abbr, kind)] = &entry;
+		return true;
+	}
+
+	void LookupIndex::rehash(size_t slotCount)
+	{
+		this->slots.assign(slotCount, 0);
+		size_t mask = slotCount - 1;
+
+		for (size_t i = 0; i < this->entries.size(); i++)
+		{
+			size_t slot = this->hashes[i] & mask;
+			while (this->slots[slot])
+				slot = (slot + 1) & mask;
+			this->slots[slot] = static_cast<uint32_t>(i + 1);
+		}
+	}
+
+	Option* LookupIndex::find(std::string_view name, ArgKind kind) const
+	{
+		if (this->slots.empty())
+			return nullptr;
+
+		uint32_t hash = detail::hashName(name);
+		size_t mask = this->slots.size() - 1;
+
+		for (size_t slot = hash & mask; this->slots[slot]; slot = (slot + 1) & mask)
+		{
+			size_t i = this->slots[slot] - 1;
+			if (this->hashes[i] == hash && this->kinds[i] == kind && nameOf(*this->entries[i], this->names[i]) == name)
+				return this->entries[i];
+		}
+
+		return nullptr;
+	}
+
+	Option* LookupIndex::find(char abbr, ArgKind kind) const
+	{
+		if (abbr == NoAbbr)
+			return nullptr;
+
+		return this->abbrs[abbrSlot(abbr, kind)];
+	}
+}
@@ -0,0 +1,17 @@
+#ifndef _h_libcmdline_instrumentation
+#define _h_libcmdline_instrumentation
+
+#include "libcmdline/stats.h"
+
+// Recording helpers for Parser member functions, compiled out unless
+// LIBCMDLINE_INSTRUMENTATION is defined
+
+#ifdef LIBCMDLINE_INSTRUMENTATION
+#define CMDLINE_PHASE(phase) detail::PhaseScope phaseScope(this->stats, this->activePhases, this->statsEpoch, phase)
+#define CMDLINE_COUNT(counter) (this->stats.counter++)
+#else
+#define CMDLINE_PHASE(phase) ((void)0)
+#define CMDLINE_COUNT(counter) ((void)0)
+#endif
+
+#endif
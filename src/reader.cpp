@@ -0,0 +1,166 @@
+#include "libcmdline/reader.h"
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace cmdline
+{
+	namespace
+	{
+		bool isBlank(std::string_view line)
+		{
+			size_t first = line.find_first_not_of(" \t\r");
+			return first == std::string_view::npos || line[first] == '#';
+		}
+	}
+
+	CommandReader::CommandReader(Parser& parser, int fd, size_t bufferSize)
+		: parser(parser)
+		, fd(fd)
+		, buffer(bufferSize ? bufferSize : 1, '\0')
+	{ }
+
+	bool CommandReader::next(ParseResult& result)
+	{
+		for (;;)
+		{
+			const char* data = this->buffer.data();
+			const void* nl = std::memchr(data + this->begin, '\n', this->end - this->begin);
+
+			size_t lineEnd;
+			if (nl)
+				lineEnd = static_cast<const char*>(nl) - data;
+			else if (!this->eof && this->fill())
+				continue;
+			else if (this->begin < this->end) // Last line without a newline
+				lineEnd = this->end;
+			else
+				return false;
+
+			this->current = std::string_view(data + this->begin, lineEnd - this->begin);
+			this->begin = std::min(lineEnd + 1, this->end);
+
+			if (isBlank(this->current))
+				continue;
+
+			result = this->parser.parseLine(this->current);
+			return true;
+		}
+	}
+
+	std::string_view CommandReader::line() const
+	{
+		return this->current;
+	}
+
+	bool CommandReader::fill()
+	{
+		// Move the partial line to the front, grow only if it fills the buffer
+		if (this->begin > 0)
+		{
+			std::memmove(&this->buffer[0], this->buffer.data() + this->begin, this->end - this->begin);
+			this->end -= this->begin;
+			this->begin = 0;
+		}
+
+		if (this->end == this->buffer.size())
+			this->buffer.resize(this->buffer.size() * 2);
+
+		for (;;)
+		{
+#ifdef _WIN32
+			int n = _read(this->fd, &this->buffer[this->end], static_cast<unsigned>(this->buffer.size() - this->end));
+#else
+			ssize_t n = ::read(this->fd, &this->buffer[this->end], this->buffer.size() - this->end);
+#endif
+			if (n < 0 && errno == EINTR)
+				continue;
+
+			if (n <= 0)
+			{
+				this->eof = true;
+				return false;
+			}
+
+			this->end += static_cast<size_t>(n);
+			return true;
+		}
+	}
+
+	CmdlineScanner::CmdlineScanner(Parser& parser, size_t bufferSize)
+		: parser(parser)
+		, defaults(parser.currentValues())
+		, data(bufferSize ? bufferSize : 1, '\0')
+	{ }
+
+	const ParseResult& CmdlineScanner::parse(std::string_view buffer)
+	{
+		this->parser.restoreValues(this->defaults);
+		this->last = this->parser.parseBuffer(buffer);
+		return this->last;
+	}
+
+	bool CmdlineScanner::parseFile(const std::string& path)
+	{
+#ifdef _WIN32
+		int fd = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+		int fd = ::open(path.c_str(), O_RDONLY);
+#endif
+		if (fd < 0)
+			return false;
+
+		// Files in /proc report no size, read until the end
+		this->size = 0;
+		bool ok = true;
+		for (;;)
+		{
+			if (this->size == this->data.size())
+				this->data.resize(this->data.size() * 2);
+
+#ifdef _WIN32
+			int n = _read(fd, &this->data[this->size], static_cast<unsigned>(this->data.size() - this->size));
+#else
+			ssize_t n = ::read(fd, &this->data[this->size], this->data.size() - this->size);
+#endif
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n < 0)
+				ok = false;
+			if (n <= 0)
+				break;
+
+			this->size += static_cast<size_t>(n);
+		}
+
+#ifdef _WIN32
+		_close(fd);
+#else
+		::close(fd);
+#endif
+		if (!ok)
+			return false;
+
+		this->parse(this->buffer());
+		return true;
+	}
+
+	const ParseResult& CmdlineScanner::result() const
+	{
+		return this->last;
+	}
+
+	std::string_view CmdlineScanner::buffer() const
+	{
+		return std::string_view(this->data.data(), this->size);
+	}
+}
@@ -0,0 +1,68 @@
+#include "libcmdline/registry.h"
+#include "libcmdline/cmdline.h"
+
+#include <atomic>
+
+namespace cmdline
+{
+	namespace
+	{
+		// Constant initialized, so flags may register during static
+		// initialization of any translation unit
+		std::atomic<const RegisteredFlag*> head { nullptr };
+	}
+
+	const RegisteredFlag* RegisteredFlag::first()
+	{
+		return head.load(std::memory_order_acquire);
+	}
+
+	void RegisteredFlag::enroll()
+	{
+		const RegisteredFlag* expected = head.load(std::memory_order_relaxed);
+		do
+			this->next = expected;
+		while (!head.compare_exchange_weak(expected, this, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	void Parser::useRegistry()
+	{
+		this->frozen = false;
+		this->registryPending = true;
+	}
+
+	void Parser::loadRegistry() const
+	{
+		this->registryPending = false;
+
+		// Newest flags are first, add them in registration order
+		std::vector<const RegisteredFlag*> flags;
+		for (const RegisteredFlag* flag = RegisteredFlag::first(); flag; flag = flag->next)
+			flags.push_back(flag);
+
+		for (auto it = flags.rbegin(); it != flags.rend(); it++)
+		{
+			const RegisteredFlag& flag = **it;
+			Option* opt;
+			ArgKind kind;
+			if (flag.isSwitch)
+			{
+				this->switches.push_back(Switch(flag.name, flag.abbr, flag.description));
+				this->attach(this->switches.back());
+				this->switches.back().setValue(*static_cast<const bool*>(flag.binding.target));
+				opt = &this->switches.back();
+				kind = ArgKind::switch_;
+			}
+			else
+			{
+				this->options.push_back(Option(flag.name, flag.abbr, "", Req::optional, flag.description));
+				this->attach(this->options.back());
+				opt = &this->options.back();
+				kind = ArgKind::option;
+			}
+
+			opt->binding = flag.binding;
+			this->index.add(*opt, kind);
+		}
+	}
+}
@@ -0,0 +1,180 @@
+#include "libcmdline/cmdline.h"
+
+namespace cmdline
+{
+	namespace
+	{
+		std::string switchValue(const Switch& sw)
+		{
+			return sw.on() ? "1" : "";
+		}
+
+		// Values of entries added since the values were taken
+		void extend(ReloadValues& values, const ReloadValues& current)
+		{
+			for (size_t i = values.arguments.size(); i < current.arguments.size(); i++)
+				values.arguments.push_back(current.arguments[i]);
+			for (size_t i = values.options.size(); i < current.options.size(); i++)
+				values.options.push_back(current.options[i]);
+		}
+	}
+
+	ParseResult Parser::reload(int argc, char** argv)
+	{
+		return this->reload(std::vector<std::string>(argv, argv + argc));
+	}
+
+	ParseResult Parser::reload(const std::vector<std::string>& args)
+	{
+		this->materializeAll();
+
+		// Bound variables don't keep their strings, so the values of the first
+		// reload are the baseline for both defaults and changes
+		ReloadValues current = this->currentValues();
+		if (!this->reloaded)
+		{
+			this->reloadDefaults = current;
+			this->reloadApplied = current;
+			this->reloaded = true;
+		}
+		extend(this->reloadDefaults, current);
+		extend(this->reloadApplied, current);
+
+		// Parse into a copy reset to the defaults, with strings instead of bindings
+		Parser next(*this);
+		next.usage = nullptr;
+		next.usageSlots.clear();
+
+		size_t pos = 0;
+		for (Argument& arg : next.args)
+		{
+			arg.binding = {};
+			arg.value = this->reloadDefaults.arguments[pos++];
+		}
+		for (Option& opt : next.options)
+		{
+			opt.binding = {};
+			opt.value = this->reloadDefaults.options[opt.id];
+		}
+		for (Switch& sw : next.switches)
+		{
+			sw.binding = {};
+			sw.setValue(!this->reloadDefaults.options[sw.id].empty());
+		}
+
+		// Stopped parses (eg. --help) leave the applied values alone
+		ParseResult result = next.parse(args);
+		if (!result || result.stopped())
+			return result;
+
+		this->cmdname = next.cmdname;
+
+		std::vector<const Argument*> changed;
+		// Generic, so that options go through their own assignValue overload
+		auto apply = [this, &result, &changed](auto& arg, std::string& applied, const std::string& value) {
+			if (value == applied)
+				return;
+
+			if (value.empty() && arg.binding)
+				arg.binding.assigned = false;
+			else
+			{
+				// Conversion into bound variables can still fail
+				ArgumentParseResult res = this->assignValue(arg, value);
+				result.merge(res);
+				if (!res.ParseResult::operator bool())
+					return;
+			}
+
+			applied = value;
+			changed.push_back(&arg);
+		};
+
+		auto nextArg = next.args.begin();
+		for (size_t i = 0; i < this->positional.size(); i++, nextArg++)
+			apply(*this->positional[i], this->reloadApplied.arguments[i], nextArg->value);
+
+		auto nextOpt = next.options.begin();
+		for (Option& opt : this->options)
+			apply(opt, this->reloadApplied.options[opt.id], (nextOpt++)->value);
+
+		auto nextSw = next.switches.begin();
+		for (Switch& sw : this->switches)
+		{
+			std::string value = switchValue(*nextSw++);
+			if (value == this->reloadApplied.options[sw.id])
+				continue;
+
+			sw.setValue(!value.empty());
+			this->reloadApplied.options[sw.id] = value;
+			changed.push_back(&sw);
+		}
+
+		this->variadicValues = next.variadicValues;
+
+		// Only the presence bits, switch states were set above
+		this->states->clearGiven();
+		for (size_t id = 0; id < this->optionCount; id++)
+		{
+			if (next.states->given(id))
+				this->states->setGiven(id);
+		}
+
+		for (const Argument* arg : changed)
+		{
+			for (const auto& cb : this->changeCallbacks)
+			{
+				if (cb.first == arg->name)
+					cb.second(*arg);
+			}
+		}
+
+		return result;
+	}
+
+	void Parser::onChange(const std::string& name, ChangeCallback callback)
+	{
+		this->changeCallbacks.emplace_back(name, std::move(callback));
+	}
+
+	ReloadValues Parser::currentValues() const
+	{
+		ReloadValues values;
+		values.options.resize(this->optionCount);
+
+		for (const Argument& arg : this->args)
+			values.arguments.push_back(arg.value);
+		for (const Option& opt : this->options)
+			values.options[opt.id] = opt.value;
+		for (const Switch& sw : this->switches)
+			values.options[sw.id] = switchValue(sw);
+
+		return values;
+	}
+
+	void Parser::restoreValues(const ReloadValues& values)
+	{
+		// Assigned in place, so strings keep their capacity
+		size_t pos = 0;
+		for (Argument& arg : this->args)
+		{
+			if (pos < values.arguments.size())
+				arg.value = values.arguments[pos++];
+			arg.binding.assigned = false;
+		}
+		for (Option& opt : this->options)
+		{
+			if (opt.id < values.options.size())
+				opt.value = values.options[opt.id];
+			opt.file = nullptr;
+			opt.binding.assigned = false;
+		}
+		for (Switch& sw : this->switches)
+		{
+			if (sw.id < values.options.size())
+				sw.setValue(!values.options[sw.id].empty());
+			sw.binding.assigned = false;
+		}
+		this->variadicValues.clear();
+	}
+}
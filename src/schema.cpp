@@ -0,0 +1,686 @@
+#include "libcmdline/schema.h"
+#include "instrumentation.h"
+#include "hash.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cmdline
+{
+	namespace
+	{
+		constexpr char Magic[8] = { 'L', 'C', 'M', 'D', 'S', 'C', 'H', '\0' };
+		constexpr uint32_t ByteOrderMark = 0x01020304;
+		constexpr uint32_t NoSection = 0xffffffff;
+
+		// The blob is a sequence of 32-bit words: the magic, the header
+		// below, the tables, and finally the string area. Strings are
+		// referenced as (offset, size) word pairs relative to the string area.
+		enum HeaderWord
+		{
+			hVersion,
+			hByteOrder,
+			hSize,
+			hEntryCount,
+			hEntriesOffset,
+			hSectionCount,
+			hSectionsOffset,
+			hIndexSize,
+			hIndexOffset,
+			hAbbrOffset,
+			hRequiredCount,
+			hRequiredOffset,
+			hAliasCount,
+			hAliasesOffset,
+			hHelp,
+			hHelpSize,
+			hStringsOffset,
+			hStringsSize,
+
+			hCount
+		};
+
+		enum EntryWord
+		{
+			eName,
+			eNameSize,
+			eValue,
+			eValueSize,
+			eDescription,
+			eDescriptionSize,
+			eHash,
+			eSection,
+			eHelpIndex,
+			eFlags, // kind | abbr << 8 | required << 16
+
+			eCount
+		};
+
+		// Aliases sorted by entry, name aliases are in the name index too
+		enum AliasWord
+		{
+			aEntry,
+			aName,
+			aNameSize,
+			aHash,
+			aAbbr, // Empty name for abbreviation aliases
+
+			aCount
+		};
+
+		enum SectionWord
+		{
+			sName,
+			sNameSize,
+			sDescription,
+			sDescriptionSize,
+
+			sCount
+		};
+
+		constexpr size_t HeaderSize = sizeof(Magic) + hCount * sizeof(uint32_t);
+		constexpr size_t AbbrTableSize = 256; // Per option kind
+
+		size_t abbrSlot(char abbr, ArgKind kind)
+		{
+			return (kind == ArgKind::option ? 0 : AbbrTableSize) + static_cast<unsigned char>(abbr);
+		}
+
+		class BlobWriter
+		{
+		public:
+			uint32_t addString(const std::string& str)
+			{
+				uint32_t offset = static_cast<uint32_t>(this->strings.size());
+				this->strings += str;
+				return offset;
+			}
+
+			void addStringRef(std::vector<uint32_t>& words, const std::string& str)
+			{
+				words.push_back(this->addString(str));
+				words.push_back(static_cast<uint32_t>(str.size()));
+			}
+
+			std::string strings;
+		};
+	}
+
+	// Blob
+
+	SchemaBlob::~SchemaBlob()
+	{
+		this->close();
+	}
+
+	ParseResult SchemaBlob::open(const std::string& path)
+	{
+		this->close();
+
+#ifdef _WIN32
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return {{ "Cannot open schema file " + path }};
+		this->storage.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+		ParseResult res = this->load(this->storage.data(), this->storage.size());
+#else
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return {{ "Cannot open schema file " + path }};
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size == 0)
+		{
+			::close(fd);
+			return {{ "Cannot read schema file " + path }};
+		}
+
+		void* mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (mapping == MAP_FAILED)
+			return {{ "Cannot map schema file " + path }};
+
+		this->mapping = mapping;
+		this->mappingLength = static_cast<size_t>(st.st_size);
+		ParseResult res = this->load(mapping, this->mappingLength);
+#endif
+
+		if (!res)
+			this->close();
+		return res;
+	}
+
+	ParseResult SchemaBlob::load(const void* data, size_t size)
+	{
+		this->data = nullptr;
+		this->length = 0;
+
+		if (reinterpret_cast<uintptr_t>(data) % alignof(uint32_t))
+			return {{ "Schema data is not aligned" }};
+		if (size < HeaderSize || std::memcmp(data, Magic, sizeof(Magic)) != 0)
+			return {{ "Not a schema blob" }};
+
+		const uint32_t* header = reinterpret_cast<const uint32_t*>(static_cast<const unsigned char*>(data) + sizeof(Magic));
+		if (header[hByteOrder] != ByteOrderMark)
+			return {{ "Schema blob was written with a different byte order" }};
+		if (header[hVersion] != SchemaBlobVersion)
+			return {{ "Unsupported schema blob version " + std::to_string(header[hVersion]) }};
+		if (header[hSize] > size)
+			return {{ "Schema blob is truncated" }};
+
+		auto fits = [&header](uint64_t offset, uint64_t count, uint64_t words) {
+			return offset % sizeof(uint32_t) == 0 && offset + count * words * sizeof(uint32_t) <= header[hSize];
+		};
+
+		uint32_t indexSize = header[hIndexSize];
+		if (
+			!fits(header[hEntriesOffset], header[hEntryCount], eCount) ||
+			!fits(header[hSectionsOffset], header[hSectionCount], sCount) ||
+			!fits(header[hIndexOffset], indexSize, 1) ||
+			!fits(header[hAbbrOffset], AbbrTableSize * 2, 1) ||
+			!fits(header[hRequiredOffset], header[hRequiredCount], 1) ||
+			!fits(header[hAliasesOffset], header[hAliasCount], aCount) ||
+			static_cast<uint64_t>(header[hStringsOffset]) + header[hStringsSize] > header[hSize] ||
+			indexSize == 0 || (indexSize & (indexSize - 1)) != 0
+		)
+			return {{ "Schema blob is corrupted" }};
+
+		this->data = static_cast<const unsigned char*>(data);
+		this->length = header[hSize];
+		return {};
+	}
+
+	void SchemaBlob::close()
+	{
+#ifndef _WIN32
+		if (this->mapping)
+			munmap(this->mapping, this->mappingLength);
+#endif
+		this->mapping = nullptr;
+		this->mappingLength = 0;
+		this->storage.clear();
+		this->data = nullptr;
+		this->length = 0;
+	}
+
+	const uint32_t* SchemaBlob::words(uint32_t offset) const
+	{
+		return reinterpret_cast<const uint32_t*>(this->data + offset);
+	}
+
+	std::string_view SchemaBlob::string(const uint32_t* ref) const
+	{
+		const uint32_t* header = this->words(sizeof(Magic));
+		if (static_cast<uint64_t>(ref[0]) + ref[1] > header[hStringsSize])
+			return {};
+		return { reinterpret_cast<const char*>(this->data) + header[hStringsOffset] + ref[0], ref[1] };
+	}
+
+	size_t SchemaBlob::size() const
+	{
+		return this->data ? this->words(sizeof(Magic))[hEntryCount] : 0;
+	}
+
+	SchemaEntry SchemaBlob::entry(size_t i) const
+	{
+		const uint32_t* header = this->words(sizeof(Magic));
+		const uint32_t* e = this->words(header[hEntriesOffset]) + i * eCount;
+
+		SchemaEntry res;
+		res.kind = static_cast<ArgKind>(e[eFlags] & 0xff);
+		res.name = this->string(e + eName);
+		res.value = this->string(e + eValue);
+		res.description = this->string(e + eDescription);
+		res.abbr = static_cast<char>((e[eFlags] >> 8) & 0xff);
+		res.required = (e[eFlags] >> 16) & 1 ? Req::required : Req::optional;
+		res.section = e[eSection] == NoSection ? -1 : static_cast<int>(e[eSection]);
+		res.helpIndex = e[eHelpIndex];
+		return res;
+	}
+
+	size_t SchemaBlob::find(std::string_view name, ArgKind kind) const
+	{
+		if (!this->data)
+			return npos;
+
+		const uint32_t* header = this->words(sizeof(Magic));
+		const uint32_t* index = this->words(header[hIndexOffset]);
+		const uint32_t* entries = this->words(header[hEntriesOffset]);
+		uint32_t mask = header[hIndexSize] - 1;
+		uint32_t hash = detail::hashName(name);
+
+		for (uint32_t slot = hash & mask, probes = 0; probes <= mask; slot = (slot + 1) & mask, probes++)
+		{
+			uint32_t i = index[slot];
+			if (i == 0)
+				return npos;
+
+			// Slots past the entries refer to aliases
+			if (i > header[hEntryCount])
+			{
+				uint32_t a = i - header[hEntryCount] - 1;
+				if (a >= header[hAliasCount])
+					return npos;
+
+				const uint32_t* alias = this->words(header[hAliasesOffset]) + a * aCount;
+				if (alias[aEntry] >= header[hEntryCount])
+					return npos;
+
+				const uint32_t* e = entries + alias[aEntry] * eCount;
+				if (
+					alias[aHash] == hash &&
+					static_cast<ArgKind>(e[eFlags] & 0xff) == kind &&
+					this->string(alias + aName) == name
+				)
+					return alias[aEntry];
+				continue;
+			}
+
+			const uint32_t* e = entries + (i - 1) * eCount;
+			if (
+				e[eHash] == hash &&
+				static_cast<ArgKind>(e[eFlags] & 0xff) == kind &&
+				this->string(e + eName) == name
+			)
+				return i - 1;
+		}
+
+		return npos;
+	}
+
+	size_t SchemaBlob::find(char abbr, ArgKind kind) const
+	{
+		if (!this->data || kind == ArgKind::argument || abbr == NoAbbr)
+			return npos;
+
+		const uint32_t* header = this->words(sizeof(Magic));
+		uint32_t i = this->words(header[hAbbrOffset])[abbrSlot(abbr, kind)];
+		if (i == 0 || i > header[hEntryCount])
+			return npos;
+		return i - 1;
+	}
+
+	size_t SchemaBlob::sectionCount() const
+	{
+		return this->data ? this->words(sizeof(Magic))[hSectionCount] : 0;
+	}
+
+	HelpSection SchemaBlob::section(size_t i) const
+	{
+		const uint32_t* header = this->words(sizeof(Magic));
+		const uint32_t* s = this->words(header[hSectionsOffset]) + i * sCount;
+		return HelpSection(std::string(this->string(s + sName)), std::string(this->string(s + sDescription)));
+	}
+
+	size_t SchemaBlob::aliasCount() const
+	{
+		return this->data ? this->words(sizeof(Magic))[hAliasCount] : 0;
+	}
+
+	SchemaAlias SchemaBlob::alias(size_t i) const
+	{
+		const uint32_t* header = this->words(sizeof(Magic));
+		const uint32_t* a = this->words(header[hAliasesOffset]) + i * aCount;
+
+		SchemaAlias res;
+		res.entry = a[aEntry];
+		res.name = this->string(a + aName);
+		res.abbr = static_cast<char>(a[aAbbr]);
+		return res;
+	}
+
+	std::string_view SchemaBlob::help() const
+	{
+		return this->data ? this->string(this->words(sizeof(Magic)) + hHelp) : std::string_view();
+	}
+
+	size_t SchemaBlob::requiredCount() const
+	{
+		return this->data ? this->words(sizeof(Magic))[hRequiredCount] : 0;
+	}
+
+	size_t SchemaBlob::required(size_t i) const
+	{
+		const uint32_t* header = this->words(sizeof(Magic));
+		return this->words(header[hRequiredOffset])[i];
+	}
+
+	// Parser
+
+	std::string Parser::saveSchema() const
+	{
+		this->materializeAll();
+
+		std::vector<const Argument*> entries;
+		std::vector<ArgKind> kinds;
+		for (const Argument& arg : this->args)
+		{
+			entries.push_back(&arg);
+			kinds.push_back(ArgKind::argument);
+		}
+		for (const Option& opt : this->options)
+		{
+			entries.push_back(&opt);
+			kinds.push_back(ArgKind::option);
+		}
+		for (const Switch& sw : this->switches)
+		{
+			entries.push_back(&sw);
+			kinds.push_back(ArgKind::switch_);
+		}
+
+		size_t names = entries.size();
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			if (kinds[i] != ArgKind::argument)
+				names += static_cast<const Option*>(entries[i])->aliases.size();
+		}
+
+		uint32_t indexSize = 1;
+		while (indexSize < names * 2)
+			indexSize *= 2;
+
+		BlobWriter writer;
+		std::vector<uint32_t> entryWords;
+		std::vector<uint32_t> sectionWords;
+		std::vector<uint32_t> index(indexSize, 0);
+		std::vector<uint32_t> abbrs(AbbrTableSize * 2, 0);
+		std::vector<uint32_t> required;
+		std::vector<uint32_t> aliasWords;
+
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			const Argument& arg = *entries[i];
+			ArgKind kind = kinds[i];
+			char abbr = kind == ArgKind::argument ? NoAbbr : static_cast<const Option&>(arg).abbr;
+			uint32_t hash = detail::hashName(arg.name);
+
+			uint32_t section = NoSection;
+			for (size_t s = 0; s < this->helpSections.size(); s++)
+			{
+				if (arg.helpSection == &this->helpSections[s])
+					section = static_cast<uint32_t>(s);
+			}
+
+			writer.addStringRef(entryWords, arg.name);
+			if (kind == ArgKind::switch_)
+				writer.addStringRef(entryWords, static_cast<const Switch&>(arg).on() ? "1" : "");
+			else
+				writer.addStringRef(entryWords, arg.value);
+			writer.addStringRef(entryWords, this->getDescription(arg));
+			entryWords.push_back(hash);
+			entryWords.push_back(section);
+			entryWords.push_back(static_cast<uint32_t>(arg.helpIndex));
+			entryWords.push_back(
+				static_cast<uint32_t>(kind) |
+				static_cast<uint32_t>(static_cast<unsigned char>(abbr)) << 8 |
+				(arg.required == Req::required ? 1u : 0u) << 16
+			);
+
+			// First definition wins, like the parser lookups
+			uint32_t slot = hash & (indexSize - 1);
+			while (index[slot])
+				slot = (slot + 1) & (indexSize - 1);
+			index[slot] = static_cast<uint32_t>(i + 1);
+
+			if (abbr != NoAbbr && !abbrs[abbrSlot(abbr, kind)])
+				abbrs[abbrSlot(abbr, kind)] = static_cast<uint32_t>(i + 1);
+
+			if (arg.required == Req::required && kind != ArgKind::argument)
+				required.push_back(static_cast<uint32_t>(i));
+		}
+
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			if (kinds[i] == ArgKind::argument)
+				continue;
+
+			const Option& opt = static_cast<const Option&>(*entries[i]);
+			for (const std::string& alias : opt.aliases)
+			{
+				uint32_t hash = detail::hashName(alias);
+				uint32_t slot = hash & (indexSize - 1);
+				while (index[slot])
+					slot = (slot + 1) & (indexSize - 1);
+				index[slot] = static_cast<uint32_t>(entries.size() + aliasWords.size() / aCount + 1);
+
+				aliasWords.push_back(static_cast<uint32_t>(i));
+				writer.addStringRef(aliasWords, alias);
+				aliasWords.push_back(hash);
+				aliasWords.push_back(NoAbbr);
+			}
+
+			for (char abbr : opt.abbrAliases)
+			{
+				if (!abbrs[abbrSlot(abbr, kinds[i])])
+					abbrs[abbrSlot(abbr, kinds[i])] = static_cast<uint32_t>(i + 1);
+
+				aliasWords.push_back(static_cast<uint32_t>(i));
+				writer.addStringRef(aliasWords, "");
+				aliasWords.push_back(0);
+				aliasWords.push_back(static_cast<unsigned char>(abbr));
+			}
+		}
+
+		for (const HelpSection& hs : this->helpSections)
+		{
+			writer.addStringRef(sectionWords, hs.name);
+			writer.addStringRef(sectionWords, hs.description);
+		}
+
+		std::string help = this->helpPred ? this->helpPred() : std::string();
+		uint32_t helpOffset = writer.addString(help);
+
+		std::vector<uint32_t> header(hCount, 0);
+		uint32_t offset = static_cast<uint32_t>(HeaderSize);
+		auto place = [&offset](HeaderWord word, std::vector<uint32_t>& header, size_t words) {
+			header[word] = offset;
+			offset += static_cast<uint32_t>(words * sizeof(uint32_t));
+		};
+
+		header[hVersion] = SchemaBlobVersion;
+		header[hByteOrder] = ByteOrderMark;
+		header[hEntryCount] = static_cast<uint32_t>(entries.size());
+		place(hEntriesOffset, header, entryWords.size());
+		header[hSectionCount] = static_cast<uint32_t>(this->helpSections.size());
+		place(hSectionsOffset, header, sectionWords.size());
+		header[hIndexSize] = indexSize;
+		place(hIndexOffset, header, index.size());
+		place(hAbbrOffset, header, abbrs.size());
+		header[hRequiredCount] = static_cast<uint32_t>(required.size());
+		place(hRequiredOffset, header, required.size());
+		header[hAliasCount] = static_cast<uint32_t>(aliasWords.size() / aCount);
+		place(hAliasesOffset, header, aliasWords.size());
+		header[hHelp] = helpOffset;
+		header[hHelpSize] = static_cast<uint32_t>(help.size());
+		header[hStringsOffset] = offset;
+		header[hStringsSize] = static_cast<uint32_t>(writer.strings.size());
+		header[hSize] = offset + header[hStringsSize];
+
+		std::string blob(Magic, sizeof(Magic));
+		blob.reserve(header[hSize]);
+		for (const auto* table : { &header, &entryWords, &sectionWords, &index, &abbrs, &required, &aliasWords })
+			blob.append(reinterpret_cast<const char*>(table->data()), table->size() * sizeof(uint32_t));
+		blob += writer.strings;
+
+		return blob;
+	}
+
+	void Parser::setSchema(std::shared_ptr<const SchemaBlob> schema)
+	{
+		CMDLINE_PHASE(Phase::schema);
+
+		this->frozen = false;
+		this->schema = std::move(schema);
+		this->materialized.assign(this->schema ? this->schema->size() : 0, false);
+		this->schemaSectionBase = this->helpSections.size();
+
+		if (!this->schema)
+			return;
+
+		this->helpSections.reserve(this->helpSections.size() + this->schema->sectionCount());
+		for (size_t i = 0; i < this->schema->sectionCount(); i++)
+			this->helpSections.push_back(this->schema->section(i));
+
+		// Help text and descriptions are read from the blob when help is written
+		if (!this->schema->help().empty())
+		{
+			this->setHelp([schema = this->schema]() {
+				return std::string(schema->help());
+			});
+		}
+
+		// Positional arguments are few and looked up by position, so they are
+		// created right away. Options and switches are created on first lookup.
+		for (size_t i = 0; i < this->schema->size(); i++)
+		{
+			if (this->schema->entry(i).kind == ArgKind::argument)
+				this->materialize(i);
+		}
+	}
+
+	size_t Parser::schemaFind(std::string_view name, ArgKind kind) const
+	{
+		return this->schema ? this->schema->find(name, kind) : SchemaBlob::npos;
+	}
+
+	size_t Parser::schemaFind(char abbr, ArgKind kind) const
+	{
+		return this->schema ? this->schema->find(abbr, kind) : SchemaBlob::npos;
+	}
+
+	Argument* Parser::materialize(size_t i) const
+	{
+		if (i == SchemaBlob::npos || i >= this->materialized.size() || this->materialized[i])
+			return nullptr;
+
+		SchemaEntry e = this->schema->entry(i);
+		std::string name(e.name);
+		std::string value(e.value);
+
+		Argument* arg = nullptr;
+		switch (e.kind)
+		{
+		case ArgKind::argument:
+			this->args.push_back(Argument(name, value, e.required));
+			arg = &this->args.back();
+			this->positional.push_back(arg);
+			break;
+		case ArgKind::option:
+			this->options.push_back(Option(name, e.abbr, value, e.required));
+			arg = &this->options.back();
+			break;
+		case ArgKind::switch_:
+			this->switches.push_back(Switch(name, e.abbr));
+			this->switches.back().value = value;
+			arg = &this->switches.back();
+			break;
+		}
+
+		if (e.kind != ArgKind::argument)
+		{
+			// Aliases are sorted by entry
+			Option& opt = static_cast<Option&>(*arg);
+			size_t lo = 0;
+			size_t hi = this->schema->aliasCount();
+			while (lo < hi)
+			{
+				size_t mid = (lo + hi) / 2;
+				if (this->schema->alias(mid).entry < i)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+
+			for (; lo < this->schema->aliasCount(); lo++)
+			{
+				SchemaAlias alias = this->schema->alias(lo);
+				if (alias.entry != i)
+					break;
+				if (alias.name.empty())
+					opt.abbrAliases.push_back(alias.abbr);
+				else
+					opt.aliases.emplace_back(alias.name);
+			}
+		}
+
+		if (e.kind == ArgKind::option)
+		{
+			this->attach(static_cast<Option&>(*arg));
+			this->index.add(static_cast<Option&>(*arg), ArgKind::option);
+		}
+		else if (e.kind == ArgKind::switch_)
+		{
+			this->attach(static_cast<Switch&>(*arg));
+			this->index.add(static_cast<Switch&>(*arg), ArgKind::switch_);
+		}
+
+		if (e.section >= 0 && this->schemaSectionBase + e.section < this->helpSections.size())
+			arg->helpSection = const_cast<HelpSection*>(&this->helpSections[this->schemaSectionBase + e.section]);
+		arg->helpIndex = e.helpIndex;
+
+		this->materialized[i] = true;
+		return arg;
+	}
+
+	void Parser::materializeAll() const
+	{
+		if (this->registryPending)
+			this->loadRegistry();
+		this->inheritAll();
+		if (!this->schema)
+			return;
+
+		bool created = false;
+		for (size_t i = 0; i < this->materialized.size(); i++)
+		{
+			if (!this->materialized[i])
+				created |= this->materialize(i) != nullptr;
+		}
+
+		if (!created)
+			return;
+
+		// Entries created on lookup were appended out of order, restore the
+		// schema order. Entries added by hand go after the schema entries.
+		auto byKind = [this](ArgKind kind) {
+			return [this, kind](const Argument& a, const Argument& b) {
+				return this->schemaFind(a.name, kind) < this->schemaFind(b.name, kind);
+			};
+		};
+		this->options.sort(byKind(ArgKind::option));
+		this->switches.sort(byKind(ArgKind::switch_));
+	}
+
+	bool Parser::schemaRequiresMissing(std::string& name) const
+	{
+		if (!this->schema)
+			return false;
+
+		for (size_t r = 0; r < this->schema->requiredCount(); r++)
+		{
+			size_t i = this->schema->required(r);
+			if (i >= this->materialized.size() || this->materialized[i])
+				continue;
+
+			SchemaEntry e = this->schema->entry(i);
+			if (e.kind == ArgKind::option && e.value.empty())
+			{
+				name = std::string(e.name);
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
@@ -0,0 +1,159 @@
+#include "libcmdline/stats.h"
+
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+#ifdef LIBCMDLINE_INSTRUMENTATION
+namespace
+{
+	thread_local uint64_t allocations = 0;
+}
+
+// Instrumented builds count every allocation made by the process so that
+// the parser phases can report their share. Never compiled otherwise.
+
+void* operator new(std::size_t size)
+{
+	allocations++;
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+#endif
+
+namespace cmdline
+{
+	const char* phaseName(Phase phase)
+	{
+		switch (phase)
+		{
+		case Phase::schema: return "schema";
+		case Phase::parse: return "parse";
+		case Phase::validate: return "validate";
+		case Phase::help: return "help";
+		default: return "unknown";
+		}
+	}
+
+	std::string ParserStats::toChromeTrace() const
+	{
+		std::stringstream str;
+		str << "{\"traceEvents\":[";
+
+		bool first = true;
+		for (const TraceEvent& ev : this->events)
+		{
+			if (!first)
+				str << ",";
+			first = false;
+
+			// Chrome trace timestamps are in microseconds
+			str << "{\"name\":\"" << phaseName(ev.phase) << "\""
+				<< ",\"cat\":\"libcmdline\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+				<< ",\"ts\":" << ev.start / 1000.0
+				<< ",\"dur\":" << ev.duration / 1000.0 << "}";
+		}
+
+		str << "],\"otherData\":{"
+			<< "\"tokens\":" << this->tokens
+			<< ",\"lookups\":" << this->lookups
+			<< ",\"predicateEvaluations\":" << this->predicateEvaluations;
+
+		for (size_t i = 0; i < static_cast<size_t>(Phase::count); i++)
+		{
+			const PhaseStats& ps = this->phases[i];
+			const char* name = phaseName(static_cast<Phase>(i));
+			str << ",\"" << name << "Calls\":" << ps.calls
+				<< ",\"" << name << "Nanoseconds\":" << ps.nanoseconds
+				<< ",\"" << name << "Allocations\":" << ps.allocations;
+		}
+
+		str << "}}";
+		return str.str();
+	}
+
+	namespace detail
+	{
+		uint64_t allocationCount()
+		{
+#ifdef LIBCMDLINE_INSTRUMENTATION
+			return allocations;
+#else
+			return 0;
+#endif
+		}
+
+#ifdef LIBCMDLINE_INSTRUMENTATION
+		PhaseScope::PhaseScope(ParserStats& stats, unsigned& activePhases, std::chrono::steady_clock::time_point epoch, Phase phase)
+			: epoch(epoch)
+			, phase(phase)
+		{
+			unsigned bit = 1u << static_cast<unsigned>(phase);
+			if (activePhases & bit)
+				return;
+
+			activePhases |= bit;
+			this->stats = &stats;
+			this->activePhases = &activePhases;
+			this->allocations = allocationCount();
+			this->start = std::chrono::steady_clock::now();
+		}
+
+		PhaseScope::~PhaseScope()
+		{
+			if (!this->stats)
+				return;
+
+			auto end = std::chrono::steady_clock::now();
+			uint64_t allocs = allocationCount() - this->allocations;
+			uint64_t duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - this->start).count();
+			uint64_t start = std::chrono::duration_cast<std::chrono::nanoseconds>(this->start - this->epoch).count();
+
+			*this->activePhases &= ~(1u << static_cast<unsigned>(this->phase));
+
+			PhaseStats& ps = (*this->stats)[this->phase];
+			ps.calls++;
+			ps.nanoseconds += duration;
+			ps.allocations += allocs;
+
+			// Consecutive schema building calls are reported as one span
+			auto& events = this->stats->events;
+			if (this->phase == Phase::schema && !events.empty() && events.back().phase == Phase::schema)
+				events.back().duration = start + duration - events.back().start;
+			else
+			{
+				// Growing the event list is hidden from the allocation counter
+				uint64_t before = allocationCount();
+				events.push_back({ this->phase, start, duration });
+				::allocations = before;
+			}
+		}
+#endif
+	}
+}
@@ -0,0 +1,111 @@
+#include "libcmdline/tokenizer.h"
+
+namespace cmdline
+{
+	namespace
+	{
+		bool isSpace(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+		}
+
+		// Characters a backslash escapes within double quotes
+		bool isQuotedEscape(char c)
+		{
+			return c == '"' || c == '\\' || c == '$' || c == '`' || c == '\n';
+		}
+	}
+
+	bool LineTokenizer::tokenize(std::string_view line)
+	{
+		this->buffer.clear();
+		this->spans.clear();
+		this->views.clear();
+		this->errorMsg = nullptr;
+
+		// Unescaping never makes the line longer
+		this->buffer.reserve(line.size());
+
+		bool inToken = false;
+		size_t start = 0;
+		char quote = 0;
+
+		for (size_t i = 0; i < line.size(); i++)
+		{
+			char c = line[i];
+
+			if (quote == '\'')
+			{
+				if (c == '\'')
+					quote = 0;
+				else
+					this->buffer.push_back(c);
+				continue;
+			}
+
+			if (quote == '"')
+			{
+				if (c == '"')
+					quote = 0;
+				else if (c == '\\' && i + 1 < line.size() && isQuotedEscape(line[i + 1]))
+					this->buffer.push_back(line[++i]);
+				else
+					this->buffer.push_back(c);
+				continue;
+			}
+
+			if (isSpace(c))
+			{
+				if (inToken)
+				{
+					this->spans.push_back({ start, this->buffer.size() - start });
+					inToken = false;
+				}
+				continue;
+			}
+
+			if (!inToken)
+			{
+				if (c == '#')
+					break;
+
+				inToken = true;
+				start = this->buffer.size();
+			}
+
+			if (c == '\'' || c == '"')
+				quote = c;
+			else if (c == '\\')
+			{
+				if (i + 1 < line.size())
+					this->buffer.push_back(line[++i]);
+			}
+			else
+				this->buffer.push_back(c);
+		}
+
+		if (quote)
+		{
+			this->errorMsg = quote == '"' ? "Unterminated double quote" : "Unterminated single quote";
+			return false;
+		}
+
+		if (inToken)
+			this->spans.push_back({ start, this->buffer.size() - start });
+
+		for (const auto& span : this->spans)
+			this->views.emplace_back(this->buffer.data() + span.first, span.second);
+
+		return true;
+	}
+
+	const std::vector<std::string_view>& LineTokenizer::tokens() const
+	{
+		return this->views;
+	}
+
+	const char* LineTokenizer::error() const
+	{
+		return this->errorMsg;
+	}
+}
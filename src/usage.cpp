@@ -0,0 +1,226 @@
+#include "libcmdline/usage.h"
+#include "hash.h"
+
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace cmdline
+{
+	namespace
+	{
+		constexpr auto relaxed = std::memory_order_relaxed;
+
+		// Write the whole block with one call, so blocks appended by
+		// concurrent processes don't interleave
+		bool appendFile(const std::string& path, const std::string& data)
+		{
+#ifdef _WIN32
+			int fd = _open(path.c_str(), _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY, 0644);
+#else
+			int fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+#endif
+			if (fd < 0)
+				return false;
+
+			const char* p = data.data();
+			size_t size = data.size();
+			while (size)
+			{
+#ifdef _WIN32
+				int n = _write(fd, p, static_cast<unsigned>(size));
+#else
+				ssize_t n = ::write(fd, p, size);
+#endif
+				if (n < 0 && errno == EINTR)
+					continue;
+				if (n <= 0)
+					break;
+				p += n;
+				size -= static_cast<size_t>(n);
+			}
+
+#ifdef _WIN32
+			_close(fd);
+#else
+			::close(fd);
+#endif
+			return size == 0;
+		}
+	}
+
+	UsageCounters& UsageRecorder::counters(std::string_view name)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		auto it = this->named.find(name);
+		if (it == this->named.end())
+			it = this->named.try_emplace(std::string(name)).first;
+		return it->second;
+	}
+
+	void UsageRecorder::recordParse()
+	{
+		this->parseCount.fetch_add(1, relaxed);
+	}
+
+	void UsageRecorder::recordUnknown(std::string_view token)
+	{
+		uint32_t hash = detail::hashName(token.substr(0, token.find('=')));
+		this->addUnknown(hash ? hash : 1, 1); // 0 marks free slots
+	}
+
+	void UsageRecorder::addUnknown(uint32_t hash, uint64_t count)
+	{
+		for (size_t i = 0; i < UnknownSlots; i++)
+		{
+			UnknownSlot& slot = this->unknownSlots[(hash + i) % UnknownSlots];
+
+			uint32_t current = slot.hash.load(relaxed);
+			if (current == 0 && slot.hash.compare_exchange_strong(current, hash, relaxed))
+				current = hash;
+
+			if (current == hash)
+			{
+				slot.count.fetch_add(count, relaxed);
+				return;
+			}
+		}
+	}
+
+	uint64_t UsageRecorder::parses() const
+	{
+		return this->parseCount.load(relaxed);
+	}
+
+	std::vector<UsageEntry> UsageRecorder::entries() const
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		std::vector<UsageEntry> result;
+		result.reserve(this->named.size());
+		for (const auto& it : this->named)
+			result.push_back({ it.first, it.second.given.load(relaxed), it.second.defaulted.load(relaxed), it.second.rejected.load(relaxed) });
+		return result;
+	}
+
+	std::vector<std::pair<uint32_t, uint64_t>> UsageRecorder::unknown() const
+	{
+		std::vector<std::pair<uint32_t, uint64_t>> result;
+		for (const UnknownSlot& slot : this->unknownSlots)
+		{
+			uint64_t count = slot.count.load(relaxed);
+			if (count)
+				result.emplace_back(slot.hash.load(relaxed), count);
+		}
+		return result;
+	}
+
+	ParseResult UsageRecorder::flush(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		uint64_t parses = this->parseCount.exchange(0, relaxed);
+		std::vector<UsageEntry> entries;
+		for (auto& it : this->named)
+		{
+			UsageEntry e { it.first, it.second.given.exchange(0, relaxed), it.second.defaulted.exchange(0, relaxed), it.second.rejected.exchange(0, relaxed) };
+			if (e.given || e.defaulted || e.rejected)
+				entries.push_back(std::move(e));
+		}
+
+		std::vector<std::pair<UnknownSlot*, uint64_t>> unknown;
+		for (UnknownSlot& slot : this->unknownSlots)
+		{
+			if (uint64_t count = slot.count.exchange(0, relaxed))
+				unknown.emplace_back(&slot, count);
+		}
+
+		std::stringstream str;
+		str << "usage 1 " << parses << "\n";
+		for (const UsageEntry& e : entries)
+			str << "o " << e.given << " " << e.defaulted << " " << e.rejected << " " << e.name << "\n";
+		for (const auto& u : unknown)
+			str << "u " << u.first->hash.load(relaxed) << " " << u.second << "\n";
+
+		if (appendFile(path, str.str()))
+			return {};
+
+		// Keep the counters for the next attempt
+		this->parseCount.fetch_add(parses, relaxed);
+		for (const UsageEntry& e : entries)
+		{
+			UsageCounters& c = this->named.find(e.name)->second;
+			c.given.fetch_add(e.given, relaxed);
+			c.defaulted.fetch_add(e.defaulted, relaxed);
+			c.rejected.fetch_add(e.rejected, relaxed);
+		}
+		for (const auto& u : unknown)
+			u.first->count.fetch_add(u.second, relaxed);
+
+		return {{ "Cannot write usage file " + path }};
+	}
+
+	ParseResult UsageRecorder::merge(const std::string& path)
+	{
+		std::ifstream file(path);
+		if (!file)
+			return {{ "Cannot open usage file " + path }};
+
+		std::string line;
+		size_t lineNumber = 0;
+		while (std::getline(file, line))
+		{
+			lineNumber++;
+			std::istringstream in(line);
+			std::string kind;
+			in >> kind;
+
+			bool ok = true;
+			if (kind == "usage")
+			{
+				unsigned version;
+				uint64_t parses;
+				ok = static_cast<bool>(in >> version >> parses) && version == 1;
+				if (ok)
+					this->parseCount.fetch_add(parses, relaxed);
+			}
+			else if (kind == "o")
+			{
+				uint64_t given, defaulted, rejected;
+				std::string name;
+				ok = static_cast<bool>(in >> given >> defaulted >> rejected) && in.get() == ' ' && std::getline(in, name);
+				if (ok)
+				{
+					UsageCounters& c = this->counters(name);
+					c.given.fetch_add(given, relaxed);
+					c.defaulted.fetch_add(defaulted, relaxed);
+					c.rejected.fetch_add(rejected, relaxed);
+				}
+			}
+			else if (kind == "u")
+			{
+				uint32_t hash;
+				uint64_t count;
+				ok = static_cast<bool>(in >> hash >> count) && hash != 0;
+				if (ok)
+					this->addUnknown(hash, count);
+			}
+			else
+				ok = line.empty();
+
+			if (!ok)
+				return {{ "Malformed usage file " + path + " at line " + std::to_string(lineNumber) }};
+		}
+
+		return {};
+	}
+}
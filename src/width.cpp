@@ -0,0 +1,176 @@
+#include "libcmdline/width.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CMDLINE_WIDTH_SSE2
+#endif
+
+namespace cmdline
+{
+	namespace
+	{
+		struct Range
+		{
+			char32_t first;
+			char32_t last;
+		};
+
+		// Zero width combining marks and format characters
+		const Range zeroWidth[] = {
+			{ 0x0300, 0x036F }, { 0x0483, 0x0489 }, { 0x0591, 0x05BD }, { 0x0610, 0x061A },
+			{ 0x064B, 0x065F }, { 0x0670, 0x0670 }, { 0x06D6, 0x06DC }, { 0x0900, 0x0902 },
+			{ 0x093C, 0x093C }, { 0x0941, 0x0948 }, { 0x094D, 0x094D }, { 0x0E31, 0x0E31 },
+			{ 0x0E34, 0x0E3A }, { 0x0E47, 0x0E4E }, { 0x1AB0, 0x1AFF }, { 0x1DC0, 0x1DFF },
+			{ 0x200B, 0x200F }, { 0x202A, 0x202E }, { 0x2060, 0x2064 }, { 0x20D0, 0x20FF },
+			{ 0xFE00, 0xFE0F }, { 0xFE20, 0xFE2F }, { 0xFEFF, 0xFEFF }, { 0xE0100, 0xE01EF },
+		};
+
+		// East Asian wide and fullwidth characters, and emoji presentation
+		const Range wide[] = {
+			{ 0x1100, 0x115F }, { 0x231A, 0x231B }, { 0x2329, 0x232A }, { 0x23E9, 0x23EC },
+			{ 0x25FD, 0x25FE }, { 0x2614, 0x2615 }, { 0x2648, 0x2653 }, { 0x26AA, 0x26AB },
+			{ 0x26BD, 0x26BE }, { 0x26C4, 0x26C5 }, { 0x26F2, 0x26F5 }, { 0x2705, 0x2705 },
+			{ 0x270A, 0x270B }, { 0x2728, 0x2728 }, { 0x274C, 0x274C }, { 0x2753, 0x2755 },
+			{ 0x2795, 0x2797 }, { 0x2B1B, 0x2B1C }, { 0x2E80, 0x303E }, { 0x3041, 0x33FF },
+			{ 0x3400, 0x4DBF }, { 0x4E00, 0x9FFF }, { 0xA000, 0xA4CF }, { 0xA960, 0xA97F },
+			{ 0xAC00, 0xD7A3 }, { 0xF900, 0xFAFF }, { 0xFE10, 0xFE19 }, { 0xFE30, 0xFE6F },
+			{ 0xFF00, 0xFF60 }, { 0xFFE0, 0xFFE6 }, { 0x1F300, 0x1F64F }, { 0x1F900, 0x1F9FF },
+			{ 0x20000, 0x2FFFD }, { 0x30000, 0x3FFFD },
+		};
+
+		template <size_t N>
+		bool inRanges(const Range (&ranges)[N], char32_t cp)
+		{
+			size_t lo = 0;
+			size_t hi = N;
+			while (lo < hi)
+			{
+				size_t mid = (lo + hi) / 2;
+				if (cp > ranges[mid].last)
+					lo = mid + 1;
+				else if (cp < ranges[mid].first)
+					hi = mid;
+				else
+					return true;
+			}
+			return false;
+		}
+
+		// Length of the ASCII prefix of [p, end)
+		size_t asciiPrefix(const char* p, const char* end)
+		{
+			const char* start = p;
+
+#ifdef CMDLINE_WIDTH_SSE2
+			while (end - p >= 16)
+			{
+				__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+				if (_mm_movemask_epi8(chunk))
+					break;
+				p += 16;
+			}
+#else
+			while (end - p >= 8)
+			{
+				uint64_t chunk;
+				std::memcpy(&chunk, p, sizeof(chunk));
+				if (chunk & 0x8080808080808080ull)
+					break;
+				p += 8;
+			}
+#endif
+
+			while (p != end && !(static_cast<unsigned char>(*p) & 0x80))
+				p++;
+			return p - start;
+		}
+
+		// Decode one sequence, returns its length or 0 if it's invalid
+		size_t decode(const unsigned char* p, const unsigned char* end, char32_t& cp)
+		{
+			size_t len;
+			if (p[0] >= 0xF0 && p[0] <= 0xF4)
+			{
+				len = 4;
+				cp = p[0] & 0x07;
+			}
+			else if (p[0] >= 0xE0)
+			{
+				len = 3;
+				cp = p[0] & 0x0F;
+			}
+			else if (p[0] >= 0xC2 && p[0] <= 0xDF)
+			{
+				len = 2;
+				cp = p[0] & 0x1F;
+			}
+			else
+				return 0;
+
+			if (static_cast<size_t>(end - p) < len)
+				return 0;
+
+			for (size_t i = 1; i < len; i++)
+			{
+				if ((p[i] & 0xC0) != 0x80)
+					return 0;
+				cp = (cp << 6) | (p[i] & 0x3F);
+			}
+
+			// Overlong forms, surrogates and values past U+10FFFF
+			if ((len == 3 && cp < 0x800) || (len == 4 && (cp < 0x10000 || cp > 0x10FFFF)) || (cp >= 0xD800 && cp <= 0xDFFF))
+				return 0;
+
+			return len;
+		}
+	}
+
+	int codepointWidth(char32_t cp)
+	{
+		if (cp >= 0x80 && cp < 0xA0)
+			return 0;
+		if (cp < 0x300)
+			return 1;
+		if (inRanges(zeroWidth, cp))
+			return 0;
+		if (inRanges(wide, cp))
+			return 2;
+		return 1;
+	}
+
+	size_t displayWidth(std::string_view text)
+	{
+		const char* p = text.data();
+		const char* end = p + text.size();
+		size_t width = 0;
+
+		while (p != end)
+		{
+			// ASCII is one column per byte, only the rest is decoded
+			size_t ascii = asciiPrefix(p, end);
+			width += ascii;
+			p += ascii;
+
+			if (p == end)
+				break;
+
+			char32_t cp;
+			size_t len = decode(reinterpret_cast<const unsigned char*>(p), reinterpret_cast<const unsigned char*>(end), cp);
+			if (len)
+			{
+				width += codepointWidth(cp);
+				p += len;
+			}
+			else
+			{
+				width++;
+				p++;
+			}
+		}
+
+		return width;
+	}
+}
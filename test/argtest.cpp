@@ -41,3 +41,23 @@ TEST_CASE("Argument custom enable predicate", "[argument]")
 	myVar = 42;
 	REQUIRE(arg.enabled() == true);
 }
+
+TEST_CASE("Argument kinds", "[argument]")
+{
+	cmdline::Argument arg("arg");
+	cmdline::Option opt("opt");
+	cmdline::Switch sw("sw");
+
+	REQUIRE(arg.kind == cmdline::ArgKind::argument);
+	REQUIRE(opt.kind == cmdline::ArgKind::option);
+	REQUIRE(sw.kind == cmdline::ArgKind::switch_);
+
+	// Seen through the base class
+	const cmdline::Argument& base = sw;
+	REQUIRE(base.kind == cmdline::ArgKind::switch_);
+	REQUIRE_FALSE(base.expectsValue());
+	REQUIRE(static_cast<const cmdline::Argument&>(opt).expectsValue());
+	REQUIRE_FALSE(arg.expectsValue());
+	REQUIRE(cmdline::Parser::getArgRepresentation(sw) == "--sw");
+	REQUIRE(cmdline::Parser::getArgRepresentation(opt) == "--opt [value]");
+}
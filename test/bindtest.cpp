@@ -0,0 +1,130 @@
+#include "libcmdline/cmdline.h"
+
+#include <catch2/catch_all.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <chrono>
+
+using namespace Catch::Matchers;
+
+enum class Level
+{
+	low = 1,
+	high = 2
+};
+
+TEST_CASE("Binding options to variables", "[bind]")
+{
+	int threads = 1;
+	double ratio = 0;
+	std::string name = "default";
+	Level level = Level::low;
+
+	cmdline::Parser parser;
+	auto& opt = parser.addOption("threads", 'j', threads);
+	parser.addOption("ratio", cmdline::NoAbbr, ratio);
+	parser.addOption("name", 'n').bindTo(name); // Strings bind explicitly
+	parser.addOption("level", cmdline::NoAbbr, level);
+
+	REQUIRE_FALSE(opt);
+
+	auto res = parser.parse({"appname", "-j8", "--ratio=0.5", "-n", "abc", "--level", "2"});
+	INFO(res.errorStr());
+	REQUIRE(res);
+	REQUIRE(threads == 8);
+	REQUIRE(ratio == 0.5);
+	REQUIRE(name == "abc");
+	REQUIRE(level == Level::high);
+
+	// Bound values bypass the string value
+	REQUIRE(opt.value.empty());
+	REQUIRE(opt);
+}
+
+TEST_CASE("Binding string default value", "[bind]")
+{
+	// String lvalues passed as a default value are not bound
+	std::string def = "default";
+
+	cmdline::Parser parser;
+	auto& opt = parser.addOption("opt", 'o', def);
+	parser.parse({"appname", "--opt=1"});
+
+	REQUIRE(opt.value == "1");
+	REQUIRE(def == "default");
+}
+
+TEST_CASE("Binding switches", "[bind]")
+{
+	bool verbose = false;
+	bool other = false;
+
+	cmdline::Parser parser;
+	auto& sw = parser.addSwitch("verbose", 'v', verbose);
+	parser.addSwitch("other", 'o', other);
+
+	REQUIRE(parser.parse({"appname", "-v"}));
+	REQUIRE(verbose);
+	REQUIRE_FALSE(other);
+	REQUIRE(sw.on());
+}
+
+TEST_CASE("Binding arguments and lists", "[bind]")
+{
+	unsigned count = 0;
+	std::vector<int> ids;
+
+	cmdline::Parser parser;
+	parser.addArgument("count", count);
+	parser.addOption("id", 'i', ids);
+
+	auto res = parser.parse({"appname", "5", "--id=1", "-i", "2", "-i3"});
+	INFO(res.errorStr());
+	REQUIRE(res);
+	REQUIRE(count == 5);
+	REQUIRE(ids == std::vector<int>{ 1, 2, 3 });
+}
+
+TEST_CASE("Binding durations", "[bind]")
+{
+	std::chrono::milliseconds timeout { 0 };
+	std::chrono::seconds interval { 0 };
+
+	cmdline::Parser parser;
+	parser.addOption("timeout", 't', timeout);
+	parser.addOption("interval", cmdline::NoAbbr, interval);
+
+	REQUIRE(parser.parse({"appname", "--timeout=250", "--interval=2min"}));
+	REQUIRE(timeout.count() == 250);
+	REQUIRE(interval.count() == 120);
+
+	REQUIRE(parser.parse({"appname", "--timeout=2s"}));
+	REQUIRE(timeout.count() == 2000);
+}
+
+TEST_CASE("Invalid bound values", "[bind]")
+{
+	int threads = 4;
+
+	cmdline::Parser parser;
+	parser.addOption("threads", 'j', threads);
+
+	auto res = parser.parse({"appname", "--threads=many"});
+	REQUIRE_FALSE(res);
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("Invalid value \"many\" for threads"));
+	REQUIRE(threads == 4);
+}
+
+TEST_CASE("Required bound option", "[bind]")
+{
+	int port = 0;
+
+	cmdline::Parser parser;
+	parser.addOption("port", 'p', port, cmdline::Req::required);
+
+	auto res = parser.parse({"appname"});
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("port is required"));
+
+	REQUIRE(parser.parse({"appname", "-p", "80"}));
+	REQUIRE(port == 80);
+}
@@ -0,0 +1,82 @@
+#include "libcmdline/cmdline.h"
+
+#include <catch2/catch_all.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+using namespace Catch::Matchers;
+
+TEST_CASE("Choice constraints", "[constraint]")
+{
+	cmdline::Parser parser;
+	auto& mode = parser.addOption("mode", 'm').setChoices({ "fast", "safe", "slow" });
+
+	auto res = parser.parse({"appname", "--mode=safe"});
+	INFO(res.errorStr());
+	REQUIRE(res);
+	REQUIRE(mode.value == "safe");
+
+	res = parser.parse({"appname", "-m", "other"});
+	REQUIRE_FALSE(res);
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("Invalid value \"other\" for mode, must be one of fast, safe, slow"));
+	REQUIRE(mode.value == "safe");
+}
+
+TEST_CASE("Range constraints", "[constraint]")
+{
+	int threads = 0;
+
+	cmdline::Parser parser;
+	parser.addOption("threads", 'j', threads).setRange(1, 64);
+	auto& ratio = parser.addArgument("ratio").setRange(0, 1);
+
+	auto res = parser.parse({"appname", "0.25", "-j8"});
+	INFO(res.errorStr());
+	REQUIRE(res);
+	REQUIRE(threads == 8);
+	REQUIRE(ratio.value == "0.25");
+
+	res = parser.parse({"appname", "0.5", "-j65"});
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("must be a number between 1 and 64"));
+	REQUIRE(threads == 8);
+
+	res = parser.parse({"appname", "half"});
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("Invalid value \"half\" for ratio"));
+}
+
+TEST_CASE("Pattern constraints", "[constraint]")
+{
+	cmdline::Parser parser;
+	auto& host = parser.addOption("host").setPattern("[a-z0-9.-]+(:[0-9]+)?");
+
+	REQUIRE(parser.parse({"appname", "--host=example.com:80"}));
+	REQUIRE(host.value == "example.com:80");
+
+	auto res = parser.parse({"appname", "--host=Not a host"});
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("must match"));
+}
+
+TEST_CASE("Combined constraints", "[constraint]")
+{
+	cmdline::Argument arg("level");
+	arg.setChoices({ "1", "2", "30" }).setRange(1, 10);
+
+	cmdline::Argument copy = arg;
+	copy.setChoices({ "40" });
+
+	REQUIRE(arg.constraints->check("2").empty());
+	REQUIRE_FALSE(arg.constraints->check("30").empty());
+	REQUIRE_FALSE(arg.constraints->check("3").empty());
+	REQUIRE(arg.constraints->getChoices().size() == 3);
+	REQUIRE(copy.constraints->getChoices().size() == 1);
+}
+
+TEST_CASE("Choices in help", "[constraint]")
+{
+	cmdline::Parser parser;
+	parser.addOption("mode", 'm').setChoices({ "fast", "slow" }).setDescription("Mode");
+	parser.addOption("level").setChoices({ "1", "2" });
+
+	auto help = parser.getHelp();
+	REQUIRE_THAT(help, ContainsSubstring("= Mode (one of: fast, slow)"));
+	REQUIRE_THAT(help, ContainsSubstring("= (one of: 1, 2)"));
+}
@@ -0,0 +1,98 @@
+#include "libcmdline/cmdline.h"
+#include "libcmdline/events.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <string_view>
+#include <vector>
+
+using Kind = cmdline::EventKind;
+
+TEST_CASE("Event kinds", "[events]")
+{
+	cmdline::Parser parser;
+	parser.addArgument("input");
+	parser.addOption("level", 'l');
+	parser.addSwitch("verbose", 'v');
+	parser.addSwitch("quiet", 'q');
+
+	std::vector<std::string_view> tokens = { "in", "--level=3", "-l", "4", "-l5", "-vq", "--no-verbose", "--what", "-x", "--", "-v" };
+	std::vector<cmdline::ParseEvent> events;
+	for (const auto& ev : cmdline::events(parser, tokens.begin(), tokens.end()))
+		events.push_back(ev);
+
+	REQUIRE(events.size() == 11);
+
+	REQUIRE(events[0].kind == Kind::positional);
+	REQUIRE(events[0].value == "in");
+	REQUIRE(events[0].entry == parser.getArgument("input"));
+
+	REQUIRE(events[1].kind == Kind::option);
+	REQUIRE(events[1].name == "level");
+	REQUIRE(events[1].value == "3");
+	REQUIRE(events[2].kind == Kind::option);
+	REQUIRE(events[2].value == "4");
+	REQUIRE(events[3].value == "5");
+	REQUIRE(events[3].entry == parser.getOption("level"));
+
+	REQUIRE(events[4].kind == Kind::switch_);
+	REQUIRE(events[4].name == "v");
+	REQUIRE(events[5].kind == Kind::switch_);
+	REQUIRE(events[5].entry == parser.getSwitch("quiet"));
+	REQUIRE(events[6].kind == Kind::switch_);
+	REQUIRE_FALSE(events[6].on);
+
+	REQUIRE(events[7].kind == Kind::unknown);
+	REQUIRE(events[7].name == "what");
+	REQUIRE(events[8].kind == Kind::unknown);
+
+	REQUIRE(events[9].kind == Kind::terminator);
+	REQUIRE(events[10].kind == Kind::positional);
+	REQUIRE(events[10].value == "-v");
+	REQUIRE(events[10].position == 1);
+	REQUIRE(events[10].entry == nullptr);
+
+	// Reading events doesn't touch the parser
+	REQUIRE(parser.getOption("level")->value.empty());
+	REQUIRE_FALSE(parser.getSwitch("verbose")->on());
+}
+
+TEST_CASE("Events stop at a subcommand", "[events]")
+{
+	cmdline::Parser parser;
+	parser.addSwitch("verbose", 'v');
+	parser.addOption("config", 'c');
+
+	const char* argv[] = { "launcher", "-v", "-c", "file", "run", "--child-option", "-x" };
+	int argc = 7;
+
+	auto stream = cmdline::events(parser, argc, const_cast<char**>(argv));
+	std::string_view command;
+	for (const auto& ev : stream)
+	{
+		if (ev.kind == Kind::positional)
+		{
+			command = ev.value;
+			break;
+		}
+	}
+
+	REQUIRE(command == "run");
+	REQUIRE(stream.remaining() == const_cast<char**>(argv) + 5);
+}
+
+TEST_CASE("Option without value at the end", "[events]")
+{
+	cmdline::Parser parser;
+	parser.addOption("level", 'l');
+
+	std::vector<std::string_view> tokens = { "-l" };
+	auto stream = cmdline::events(parser, tokens.begin(), tokens.end());
+	auto it = stream.begin();
+
+	REQUIRE(it != stream.end());
+	REQUIRE(it->kind == Kind::option);
+	REQUIRE(it->missingValue);
+	REQUIRE(++it == stream.end());
+	REQUIRE(stream.remaining() == tokens.end());
+}
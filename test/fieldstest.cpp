@@ -0,0 +1,70 @@
+#include "libcmdline/fields.h"
+
+#include <catch2/catch_all.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <chrono>
+
+using namespace Catch::Matchers;
+
+namespace
+{
+	struct Config
+	{
+		int threads = 1;
+		bool verbose = false;
+		std::string name = "none";
+		std::chrono::milliseconds timeout { 100 };
+		std::string input;
+	};
+
+	constexpr auto configFields = cmdline::fields(
+		cmdline::field(&Config::threads, "threads", 'j', "Worker threads"),
+		cmdline::field(&Config::verbose, "verbose", 'v', "Verbose output"),
+		cmdline::field(&Config::name, "name"),
+		cmdline::field(&Config::timeout, "timeout", 't', "Timeout", cmdline::Req::required),
+		cmdline::positional(&Config::input, "input", "Input file")
+	);
+}
+
+TEST_CASE("Struct fields schema", "[fields]")
+{
+	Config config;
+	cmdline::Parser parser;
+	cmdline::addFields(parser, config, configFields);
+
+	REQUIRE(parser.getOption("threads"));
+	REQUIRE(parser.getOption('j'));
+	REQUIRE(parser.getSwitch("verbose"));
+	REQUIRE(parser.getArgument("input"));
+
+	auto help = parser.getHelp();
+	REQUIRE_THAT(help, ContainsSubstring("Worker threads"));
+	REQUIRE_THAT(help, ContainsSubstring("<input>"));
+}
+
+TEST_CASE("Struct fields parsing", "[fields]")
+{
+	Config config;
+	cmdline::Parser parser;
+	cmdline::addFields(parser, config, configFields);
+
+	auto res = parser.parse({"appname", "file.txt", "-j4", "-v", "--timeout=1s"});
+	INFO(res.errorStr());
+	REQUIRE(res);
+	REQUIRE(config.threads == 4);
+	REQUIRE(config.verbose);
+	REQUIRE(config.name == "none");
+	REQUIRE(config.timeout.count() == 1000);
+	REQUIRE(config.input == "file.txt");
+}
+
+TEST_CASE("Struct fields required", "[fields]")
+{
+	Config config;
+	cmdline::Parser parser;
+	cmdline::addFields(parser, config, configFields);
+
+	auto res = parser.parse({"appname", "file.txt"});
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("timeout is required"));
+}
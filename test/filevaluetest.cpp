@@ -0,0 +1,69 @@
+#include "libcmdline/cmdline.h"
+#include "libcmdline/filevalue.h"
+
+#include <catch2/catch_all.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <cstdio>
+#include <fstream>
+
+using namespace Catch::Matchers;
+
+namespace
+{
+	std::string writeFile(const std::string& name, const std::string& contents)
+	{
+		std::string path = "filevaluetest_" + name;
+		std::ofstream(path, std::ios::binary) << contents;
+		return path;
+	}
+}
+
+TEST_CASE("File values", "[filevalue]")
+{
+	std::string path = writeFile("policy.json", "{ \"allow\": [\"read\"] }");
+
+	cmdline::Parser parser;
+	auto& policy = parser.addOption("policy", 'p', "", cmdline::Req::optional).allowFile();
+	auto& name = parser.addOption("name", 'n', "", cmdline::Req::optional);
+
+	cmdline::ParseResult res = parser.parse({"app", "--policy=@" + path, "-n", "@literal"});
+	INFO(res.errorStr());
+	REQUIRE(res);
+	REQUIRE(policy.value == "@" + path);
+	REQUIRE(policy.file != nullptr);
+	REQUIRE(policy.file->path() == path);
+	REQUIRE(name.contents() == "@literal");
+
+	// The result keeps the mapping alive after the option moved on
+	std::string_view contents = policy.contents();
+	REQUIRE(contents == "{ \"allow\": [\"read\"] }");
+	REQUIRE(parser.parse({"app", "-p", "@@inline"}));
+	REQUIRE(policy.file == nullptr);
+	REQUIRE(policy.contents() == "@inline");
+	REQUIRE(contents == "{ \"allow\": [\"read\"] }");
+
+	std::remove(path.c_str());
+}
+
+TEST_CASE("Missing file values", "[filevalue]")
+{
+	cmdline::Parser parser;
+	auto& policy = parser.addOption("policy", 'p', "", cmdline::Req::optional).allowFile();
+	int limit = 0;
+	parser.addOption("limit", 'l', "", cmdline::Req::optional).allowFile().bindTo(limit);
+
+	// Unbound values are read lazily, so errors show up on access
+	REQUIRE(parser.parse({"app", "--policy=@filevaluetest_missing"}));
+	REQUIRE(policy.contents().empty());
+	REQUIRE_THAT(policy.file->error(), ContainsSubstring("Cannot open file filevaluetest_missing"));
+
+	auto res = parser.parse({"app", "--limit=@filevaluetest_missing"});
+	REQUIRE_FALSE(res);
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("given for limit"));
+
+	std::string path = writeFile("limit.txt", "42");
+	REQUIRE(parser.parse({"app", "--limit=@" + path}));
+	REQUIRE(limit == 42);
+	std::remove(path.c_str());
+}
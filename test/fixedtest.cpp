@@ -0,0 +1,143 @@
+#include "libcmdline/cmdline.h"
+#include "libcmdline/fixed.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <string>
+#include <vector>
+
+namespace
+{
+	using Fixed = cmdline::FixedParser<2, 2, 3>;
+
+	// Same entries in both parsers
+	void setup(cmdline::Parser& parser)
+	{
+		parser.addArgument("input");
+		parser.addArgument("output", "", cmdline::Req::optional);
+		parser.addOption("level", 'l', "1");
+		auto& advanced = parser.addSwitch("advanced", 'a');
+		parser.addOption("mode", 'm').setPred(cmdline::enableWhenSwitchIsSet(advanced));
+		parser.addSwitch("verbose", 'v');
+		parser.addSwitch("quiet", 'q');
+	}
+
+	void setup(Fixed& parser)
+	{
+		parser.addArgument("input");
+		parser.addArgument("output", "", cmdline::Req::optional);
+		parser.addOption("level", 'l', "1");
+		auto* advanced = parser.addSwitch("advanced", 'a');
+		parser.enableWhenSwitchIsSet(*parser.addOption("mode", 'm'), *advanced);
+		parser.addSwitch("verbose", 'v');
+		parser.addSwitch("quiet", 'q');
+	}
+}
+
+TEST_CASE("Fixed parser follows Parser", "[fixed]")
+{
+	std::vector<std::vector<std::string>> lines = {
+		{ "app", "in" },
+		{ "app" },
+		{ "app", "in", "out" },
+		{ "app", "in", "out", "extra" },
+		{ "app", "in", "--level=3" },
+		{ "app", "in", "--level", "4" },
+		{ "app", "in", "--level", "-v" },
+		{ "app", "in", "-l5" },
+		{ "app", "in", "-l=6" },
+		{ "app", "in", "-l", "7" },
+		{ "app", "in", "--level=" },
+		{ "app", "in", "--level" },
+		{ "app", "-vq", "in" },
+		{ "app", "in", "-v", "--no-verbose" },
+		{ "app", "in", "--mode=x" },
+		{ "app", "-a", "in", "--mode=x" },
+		{ "app", "in", "-m", "y", "-a" },
+		{ "app", "in", "--what" },
+		{ "app", "in", "-vx" },
+		{ "app", "--", "-v" },
+		{ "app", "in", "--", "--level=3" },
+		{ "app", "-", "--quiet" },
+	};
+
+	for (const auto& line : lines)
+	{
+		std::string joined;
+		for (const std::string& token : line)
+			joined += token + " ";
+		INFO(joined);
+
+		cmdline::Parser parser(false);
+		setup(parser);
+		bool parsed = static_cast<bool>(parser.parse(line));
+
+		std::vector<const char*> argv;
+		for (const std::string& token : line)
+			argv.push_back(token.c_str());
+		Fixed fixed;
+		setup(fixed);
+		auto res = fixed.parse(static_cast<int>(argv.size()), argv.data());
+
+		REQUIRE(static_cast<bool>(res) == parsed);
+		if (!parsed)
+			continue;
+
+		for (size_t i = 0; i < 2; i++)
+			REQUIRE(fixed.getArgument(i)->value == parser.getArgument(i)->value);
+		for (const char* name : { "level", "mode" })
+			REQUIRE(fixed.getOption(name)->value == parser.getOption(name)->value);
+		for (const char* name : { "advanced", "verbose", "quiet" })
+			REQUIRE(fixed.getSwitch(name)->on == parser.getSwitch(name)->on());
+	}
+}
+
+TEST_CASE("Fixed parser errors", "[fixed]")
+{
+	cmdline::FixedParser<1, 1, 1> parser;
+	REQUIRE(parser.addArgument("input"));
+	REQUIRE(parser.addOption("name", 'n', "", cmdline::Req::required));
+	REQUIRE(parser.addSwitch("force", 'f'));
+	REQUIRE(parser.addSwitch("other") == nullptr); // Full
+
+	const char* missing[] = { "app", "in" };
+	auto res = parser.parse(2, missing);
+	REQUIRE(res.error == cmdline::FixedError::missingOption);
+	REQUIRE(res.index == 0);
+
+	// Only the first error is kept
+	const char* unknown[] = { "app", "--what", "a", "b" };
+	res = parser.parse(4, unknown);
+	REQUIRE(res.error == cmdline::FixedError::unknownOption);
+	REQUIRE(res.index == 0);
+	REQUIRE(std::string(cmdline::fixedErrorName(res.error)) == "unknown option");
+
+	// Values are reset on every parse
+	const char* given[] = { "app", "in", "-n", "x", "-f" };
+	REQUIRE(parser.parse(5, given));
+	REQUIRE(parser.getSwitch('f')->on);
+	REQUIRE(parser.getCommandName() == "app");
+	REQUIRE_FALSE(parser.parse(2, missing));
+	REQUIRE_FALSE(parser.getSwitch('f')->on);
+	REQUIRE(parser.getOption('n')->value.empty());
+}
+
+TEST_CASE("Fixed parser without allocations", "[fixed]")
+{
+	Fixed parser;
+	setup(parser);
+
+	// Allocations are only counted in instrumented builds
+	const char* argv[] = { "app", "in", "out", "--level=3", "-a", "-m", "fast", "-vq" };
+	uint64_t allocs = cmdline::detail::allocationCount();
+	auto res = parser.parse(8, argv);
+	std::string_view mode = parser.getOption("mode")->value;
+	const char* bad[] = { "app", "--what", "a", "b", "c" };
+	auto failed = parser.parse(5, bad);
+	allocs = cmdline::detail::allocationCount() - allocs;
+
+	REQUIRE(allocs == 0);
+	REQUIRE(res);
+	REQUIRE_FALSE(failed);
+	REQUIRE(mode == "fast");
+}
@@ -0,0 +1,98 @@
+#include "libcmdline/cmdline.h"
+
+#include <catch2/catch_all.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+using namespace Catch::Matchers;
+
+TEST_CASE("Exclusive groups", "[group]")
+{
+	cmdline::Parser parser;
+	parser.addOption("input", 'i');
+	parser.addSwitch("stdin");
+	parser.addOption("url");
+	parser.addExclusiveGroup({ "input", "stdin", "url" }, cmdline::Req::required);
+
+	REQUIRE(parser.parse({"appname", "--stdin"}));
+	REQUIRE(parser.parse({"appname", "-i", "file"}));
+
+	auto res = parser.parse({"appname", "-i", "file", "--url=x"});
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("Options --input, --stdin, --url are mutually exclusive"));
+
+	res = parser.parse({"appname"});
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("One of --input, --stdin, --url is required"));
+}
+
+TEST_CASE("Optional exclusive groups", "[group]")
+{
+	cmdline::Parser parser;
+	parser.addSwitch("quiet", 'q');
+	parser.addSwitch("verbose", 'v');
+	parser.addExclusiveGroup({ "quiet", "verbose" });
+
+	REQUIRE(parser.parse({"appname"}));
+	REQUIRE_FALSE(parser.parse({"appname", "-qv"}));
+}
+
+TEST_CASE("At least one groups", "[group]")
+{
+	cmdline::Parser parser;
+	parser.addOption("user");
+	parser.addOption("token");
+	parser.addAtLeastOneGroup({ "user", "token" });
+
+	REQUIRE(parser.parse({"appname", "--user=a", "--token=b"}));
+	auto res = parser.parse({"appname"});
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("At least one of --user, --token is required"));
+}
+
+TEST_CASE("All or none groups", "[group]")
+{
+	cmdline::Parser parser;
+	parser.addOption("cert");
+	parser.addOption("key");
+	parser.addAllOrNoneGroup({ "cert", "key" });
+
+	REQUIRE(parser.parse({"appname"}));
+	REQUIRE(parser.parse({"appname", "--cert=a", "--key=b"}));
+	auto res = parser.parse({"appname", "--key=b"});
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("Options --cert, --key must be given together"));
+}
+
+TEST_CASE("Requirement groups", "[group]")
+{
+	cmdline::Parser parser;
+	auto& user = parser.addOption("user", 'u');
+	parser.addOption("password", 'p');
+	parser.addRequirement("user", { "password" });
+
+	REQUIRE(parser.parse({"appname"}));
+	REQUIRE(parser.parse({"appname", "--password=x"}));
+	REQUIRE(parser.parse({"appname", "-u", "me", "-p", "x"}));
+	REQUIRE(parser.isGiven(user));
+
+	// Values are kept between parses, presence is not
+	auto res = parser.parse({"appname", "-u", "me"});
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("Option --user requires --password"));
+}
+
+TEST_CASE("Many groups", "[group]")
+{
+	cmdline::Parser parser;
+	for (int i = 0; i < 200; i++)
+		parser.addSwitch("sw" + std::to_string(i));
+	for (int i = 0; i < 200; i += 2)
+		parser.addExclusiveGroup({ "sw" + std::to_string(i), "sw" + std::to_string(i + 1) });
+
+	REQUIRE(parser.parse({"appname", "--sw0", "--sw130", "--sw199"}));
+	REQUIRE_FALSE(parser.parse({"appname", "--sw0", "--sw198", "--sw199"}));
+}
+
+TEST_CASE("Groups with unknown options", "[group]")
+{
+	cmdline::Parser parser;
+	parser.addOption("a");
+	parser.addExclusiveGroup({ "a", "b" });
+
+	REQUIRE_THAT(parser.validateCommand().errorStr(), ContainsSubstring("unknown option \"b\""));
+}
@@ -1,8 +1,12 @@
 #include "libcmdline/cmdline.h"
+#include "libcmdline/width.h"
 
 #include <catch2/catch_all.hpp>
 #include <catch2/matchers/catch_matchers_string.hpp>
 
+#include <cstdio>
+#include <sstream>
+
 using namespace Catch::Matchers;
 
 TEST_CASE("Auto adding help", "[help]")
@@ -24,6 +28,50 @@ TEST_CASE("Requesting help", "[help]")
 	REQUIRE(parser.helpRequested());
 }
 
+TEST_CASE("Requesting help stops parsing", "[help]")
+{
+	cmdline::Parser parser;
+	parser.addArgument("arg"); // Required argument
+	auto& verbose = parser.addSwitch("verbose", 'v');
+	parser.addStandardVersionSwitch("1.2.3");
+
+	auto res = parser.parse({"appname", "--help", "-v", "--unknown"});
+	INFO(res.errorStr());
+	REQUIRE(res);
+	REQUIRE(res.status() == cmdline::ParseStatus::stopped);
+	REQUIRE(res.stoppedBy() == "help");
+	REQUIRE(parser.helpRequested());
+	REQUIRE_FALSE(verbose.on());
+
+	res = parser.parse({"appname", "--version"});
+	REQUIRE(res.status() == cmdline::ParseStatus::stopped);
+	REQUIRE(parser.versionRequested());
+	REQUIRE(parser.getVersion() == "1.2.3");
+
+	res = parser.parse({"appname"});
+	REQUIRE(res.status() == cmdline::ParseStatus::failed);
+	REQUIRE_FALSE(res.stopped());
+}
+
+TEST_CASE("Custom actions", "[help]")
+{
+	cmdline::Parser parser;
+	parser.addArgument("arg");
+	std::vector<std::string> seen;
+	parser.addOption("list", 'l').setAction([&seen](const cmdline::Argument& arg) {
+		seen.push_back(arg.value);
+		return arg.value == "all";
+	});
+
+	REQUIRE(parser.parse({"appname", "-l", "one", "--list=two", "x"}).status() == cmdline::ParseStatus::ok);
+	REQUIRE(seen == std::vector<std::string>{ "one", "two" });
+
+	auto res = parser.parse({"appname", "-lall", "--list=three"});
+	REQUIRE(res.stopped());
+	REQUIRE(res.stoppedBy() == "list");
+	REQUIRE(seen.back() == "all");
+}
+
 TEST_CASE("Requesting help short syntax", "[help]")
 {
 	cmdline::Parser parser;
@@ -65,3 +113,68 @@ TEST_CASE("Help arguments", "[help]")
 	REQUIRE_THAT(help, ContainsSubstring("--switch, -s         = A switch"));
 	REQUIRE_THAT(help, ContainsSubstring("--switch-simple"));
 }
+
+TEST_CASE("Help display width", "[help]")
+{
+	REQUIRE(cmdline::displayWidth("plain ascii text that spans several chunks") == 42);
+	REQUIRE(cmdline::displayWidth("größe") == 5);
+	REQUIRE(cmdline::displayWidth("日本語") == 6);
+	REQUIRE(cmdline::displayWidth("e\xcc\x81") == 1); // Combining acute accent
+	REQUIRE(cmdline::displayWidth("\xff") == 1);
+
+	cmdline::Parser parser(false);
+	parser.addArgument("größe", "", cmdline::Req::required, "Size");
+	parser.addArgument("名前", "", cmdline::Req::required, "Name");
+	parser.addArgument("count", "", cmdline::Req::required, "Count");
+
+	auto help = parser.getHelp();
+
+	REQUIRE_THAT(help, ContainsSubstring("  größe = Size\n"));
+	REQUIRE_THAT(help, ContainsSubstring("  名前  = Name\n"));
+	REQUIRE_THAT(help, ContainsSubstring("  count = Count\n"));
+}
+
+TEST_CASE("Help writer", "[help]")
+{
+	cmdline::Parser parser;
+	parser.setHelp("Example description");
+	parser.addArgument("input", "", cmdline::Req::required, "Input file");
+	for (int i = 0; i < 200; i++)
+		parser.addOption("option" + std::to_string(i), cmdline::NoAbbr, "", cmdline::Req::optional, "Description of option " + std::to_string(i));
+
+	auto help = parser.getHelp();
+	REQUIRE(help.size() > 4096);
+
+	std::stringstream str;
+	REQUIRE(parser.writeHelp(str));
+	REQUIRE(str.str() == help);
+
+	std::FILE* file = std::tmpfile();
+	REQUIRE(file);
+	REQUIRE(parser.writeHelp(file));
+	std::rewind(file);
+	std::string written(help.size() + 1, '\0');
+	written.resize(std::fread(&written[0], 1, written.size(), file));
+	std::fclose(file);
+	REQUIRE(written == help);
+}
+
+TEST_CASE("Help description provider", "[help]")
+{
+	int calls = 0;
+	cmdline::Parser parser(false);
+	parser.addOption("level", 'l');
+	parser.addOption("name", 'n', "", cmdline::Req::optional, "Own description");
+	parser.setDescriptionProvider([&calls](const cmdline::Argument& arg) {
+		calls++;
+		return arg.name == "level" ? std::string("Provided description") : std::string();
+	});
+
+	REQUIRE(parser.parse({"appname", "-l", "3"}));
+	REQUIRE(calls == 0);
+
+	auto help = parser.getHelp();
+	REQUIRE(calls == 1);
+	REQUIRE_THAT(help, ContainsSubstring("--level, -l [value] = Provided description"));
+	REQUIRE_THAT(help, ContainsSubstring("--name, -n [value]  = Own description"));
+}
@@ -0,0 +1,96 @@
+#include "libcmdline/cmdline.h"
+
+#include <catch2/catch_all.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+TEST_CASE("Lookup of many options", "[index]")
+{
+	cmdline::Parser parser;
+	for (int i = 0; i < 500; i++)
+		parser.addOption("option" + std::to_string(i));
+	for (int i = 0; i < 500; i++)
+		parser.addSwitch("switch" + std::to_string(i));
+
+	for (int i = 0; i < 500; i++)
+	{
+		REQUIRE(parser.getOption("option" + std::to_string(i))->name == "option" + std::to_string(i));
+		REQUIRE(parser.getSwitch("switch" + std::to_string(i))->name == "switch" + std::to_string(i));
+	}
+
+	REQUIRE(parser.getOption("switch1") == nullptr);
+	REQUIRE(parser.getSwitch("option1") == nullptr);
+	REQUIRE(parser.getOption("option500") == nullptr);
+
+	REQUIRE(parser.parse({"appname", "--option499=x", "--switch250"}));
+	REQUIRE(parser.getOption("option499")->value == "x");
+	REQUIRE(parser.getSwitch("switch250")->on());
+}
+
+TEST_CASE("Lookup by abbreviation", "[index]")
+{
+	cmdline::Parser parser;
+	parser.addOption("first", 'f');
+	parser.addSwitch("force", 'f');
+	parser.addOption("other", 'f');
+	parser.addOption("plain");
+
+	REQUIRE(parser.getOption('f')->name == "first");
+	REQUIRE(parser.getSwitch('f')->name == "force");
+	REQUIRE(parser.getOption(cmdline::NoAbbr) == nullptr);
+	REQUIRE(parser.getOption('x') == nullptr);
+}
+
+TEST_CASE("Copied parser looks up its own entries", "[index]")
+{
+	cmdline::Parser parser;
+	parser.addArgument("input");
+	parser.addOption("level", 'l');
+	parser.addSwitch("verbose", 'v');
+
+	cmdline::Parser copy = parser;
+	REQUIRE(copy.parse({"appname", "file", "-l", "3", "-v"}));
+
+	REQUIRE(copy.getOption("level")->value == "3");
+	REQUIRE(copy.getSwitch('v')->on());
+	REQUIRE(copy.getArgument(static_cast<size_t>(0))->value == "file");
+
+	REQUIRE(parser.getOption("level")->value.empty());
+	REQUIRE_FALSE(parser.getSwitch('v')->on());
+	REQUIRE(parser.getArgument(static_cast<size_t>(0))->value.empty());
+}
+
+TEST_CASE("Aliases", "[index]")
+{
+	cmdline::Parser parser;
+	parser.addOption("threads", 't', "1", cmdline::Req::optional, "Worker threads");
+	parser.addSwitch("color");
+
+	REQUIRE(parser.addAlias("threads", "jobs"));
+	REQUIRE(parser.addAlias("threads", 'j'));
+	REQUIRE(parser.addAlias("color", "colour"));
+
+	REQUIRE_FALSE(parser.addAlias("threads", "color"));
+	REQUIRE_FALSE(parser.addAlias("threads", "jobs"));
+	REQUIRE_FALSE(parser.addAlias("threads", 't'));
+	REQUIRE_FALSE(parser.addAlias("nonexistent", "other"));
+
+	const cmdline::Option* threads = parser.getOption("threads");
+	REQUIRE(parser.getOption("jobs") == threads);
+	REQUIRE(parser.getOption('j') == threads);
+
+	REQUIRE(parser.parse({"appname", "--jobs=4", "--colour"}));
+	REQUIRE(threads->value == "4");
+	REQUIRE(parser.isGiven(*threads));
+	REQUIRE(parser.getSwitch("color")->on());
+
+	REQUIRE(parser.parse({"appname", "-j", "8", "--no-colour"}));
+	REQUIRE(threads->value == "8");
+	REQUIRE_FALSE(parser.getSwitch("color")->on());
+
+	REQUIRE(cmdline::Parser::getArgRepresentation(*threads) == "--threads, -t, --jobs, -j [value]");
+	REQUIRE_THAT(parser.getHelp(), Catch::Matchers::ContainsSubstring("--threads, -t, --jobs, -j [value] = Worker threads"));
+
+	cmdline::Parser copy = parser;
+	REQUIRE(copy.getOption("jobs") == copy.getOption("threads"));
+	REQUIRE(copy.getOption('j') == copy.getOption("threads"));
+}
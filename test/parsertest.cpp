@@ -189,3 +189,99 @@ TEST_CASE("Command validity", "[parser]")
 
 	REQUIRE_THAT(res.errorStr(), ContainsSubstring("\"bbb\" cannot be optional"));
 }
+
+TEST_CASE("Variadic arguments", "[parser]")
+{
+	cmdline::Parser parser;
+	auto& out = parser.addArgument("output");
+	parser.addVariadic("inputs", 1, 3);
+	parser.addSwitch("verbose", 'v');
+
+	std::vector<std::string> args = {"appname", "out.txt", "a.txt", "-v", "b.txt"};
+	auto res = parser.parse(args);
+	INFO(res.errorStr());
+	REQUIRE(res);
+	REQUIRE(out.value == "out.txt");
+
+	// Values are views of the parsed strings
+	auto inputs = parser.getVariadic();
+	REQUIRE(inputs.size() == 2);
+	REQUIRE(inputs[0] == "a.txt");
+	REQUIRE(inputs[1] == "b.txt");
+	REQUIRE(inputs[1].data() == args[4].data());
+
+	res = parser.parse({"appname", "out.txt"});
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("inputs requires at least 1 values"));
+	REQUIRE(parser.getVariadic().empty());
+
+	res = parser.parse({"appname", "out.txt", "a", "b", "c", "d"});
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("does not accept 5 positional arguments"));
+}
+
+TEST_CASE("Variadic arguments after end of options", "[parser]")
+{
+	cmdline::Parser parser;
+	auto& sw = parser.addSwitch("verbose", 'v');
+	std::vector<std::string> files;
+	parser.addVariadic("files").bindTo(files);
+
+	auto res = parser.parse({"appname", "-v", "a", "--", "-v", "--", "--help"});
+	INFO(res.errorStr());
+	REQUIRE(res);
+	REQUIRE(sw.on());
+	REQUIRE(files == std::vector<std::string>{ "a", "-v", "--", "--help" });
+	REQUIRE(parser.getVariadic().size() == 4);
+	REQUIRE_FALSE(parser.helpRequested());
+	REQUIRE_THAT(parser.getHelp(), ContainsSubstring("<files>..."));
+
+	parser.addArgument("late");
+	REQUIRE_THAT(parser.validateCommand().errorStr(), ContainsSubstring("\"files\" must be the last positional argument"));
+}
+
+TEST_CASE("Freezing the schema", "[parser]")
+{
+	cmdline::Parser parser;
+	auto& sw = parser.addSwitch("advanced", 'a');
+	parser.addOption("level", 'l').setPred(cmdline::enableWhenSwitchIsSet(sw));
+	parser.addArgument("input");
+
+	auto res = parser.freeze();
+	INFO(res.errorStr());
+	REQUIRE(res);
+	REQUIRE(parser.isFrozen());
+	REQUIRE(parser.parse({"appname", "-a", "-l", "2", "in"}));
+
+	// Entries added later need another freeze
+	parser.addOption("output", 'o');
+	REQUIRE_FALSE(parser.isFrozen());
+	REQUIRE(parser.freeze());
+}
+
+TEST_CASE("Freezing reports schema defects", "[parser]")
+{
+	cmdline::Parser other;
+	auto& foreign = other.addSwitch("foreign");
+
+	cmdline::Parser parser;
+	parser.addOption("level", 'l');
+	parser.addOption("level", 'v');
+	parser.addSwitch("verbose", 'v');
+	parser.addSwitch("level");
+	parser.addArgument("input");
+	parser.addArgument("input");
+	parser.addOption("mode").setPred(cmdline::enableWhenSwitchIsSet(foreign));
+
+	auto res = parser.freeze();
+	REQUIRE_FALSE(res);
+	REQUIRE_FALSE(parser.isFrozen());
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("\"--level\" is defined more than once"));
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("\"--level\" is both an option and a switch"));
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("\"-v\" is both an option and a switch"));
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("Positional argument \"input\" is defined more than once"));
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("\"mode\" depends on a switch unknown to this parser"));
+
+	// Copies read their own switches
+	cmdline::Parser copy(other);
+	copy.addOption("level").setPred(cmdline::enableWhenSwitchIsSet(foreign));
+	REQUIRE(copy.freeze());
+}
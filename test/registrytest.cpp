@@ -0,0 +1,42 @@
+#include "libcmdline/cmdline.h"
+#include "libcmdline/registry.h"
+
+#include <catch2/catch_all.hpp>
+
+namespace
+{
+	cmdline::Flag<int> registryThreads("registry-threads", cmdline::NoAbbr, 4, "Worker threads");
+	cmdline::Flag<std::string> registryCache("registry-cache", cmdline::NoAbbr, "/tmp", "Cache directory");
+	cmdline::Flag<bool> registryColor("registry-color", cmdline::NoAbbr, true, "Colored output");
+}
+
+TEST_CASE("Registered flags", "[registry]")
+{
+	bool found = false;
+	for (const cmdline::RegisteredFlag* flag = cmdline::RegisteredFlag::first(); flag; flag = flag->next)
+		found |= flag == &registryThreads;
+	REQUIRE(found);
+
+	// Parsers ignore the registry unless asked
+	cmdline::Parser plain;
+	REQUIRE(plain.getOption("registry-threads") == nullptr);
+
+	cmdline::Parser parser;
+	parser.useRegistry();
+	REQUIRE(parser.getSwitch("registry-color") != nullptr);
+	REQUIRE(parser.getSwitch("registry-color")->on());
+
+	auto res = parser.parse({"app", "--registry-threads=8", "--no-registry-color"});
+	INFO(res.errorStr());
+	REQUIRE(res);
+	REQUIRE(*registryThreads == 8);
+	REQUIRE(registryCache->size() == 4);
+	REQUIRE_FALSE(registryColor.get());
+
+	// Listed in registration order
+	auto options = parser.getOptions();
+	REQUIRE(options.size() == 2);
+	REQUIRE(options[0].get().name == "registry-threads");
+	REQUIRE(options[1].get().name == "registry-cache");
+	REQUIRE(parser.getHelp().find("Cache directory") != std::string::npos);
+}
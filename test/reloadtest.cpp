@@ -0,0 +1,91 @@
+#include "libcmdline/cmdline.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <map>
+
+TEST_CASE("Reload applies changed entries", "[reload]")
+{
+	cmdline::Parser parser;
+	auto& port = parser.addOption("port", 'p', "8080");
+	auto& host = parser.addOption("host", 'h', "localhost");
+	auto& verbose = parser.addSwitch("verbose", 'v');
+
+	std::map<std::string, int> changes;
+	for (const char* name : { "port", "host", "verbose" })
+	{
+		parser.onChange(name, [&changes](const cmdline::Argument& arg) {
+			changes[arg.name]++;
+		});
+	}
+
+	REQUIRE(parser.reload({"service", "--port=9000", "-v"}));
+	REQUIRE(port.value == "9000");
+	REQUIRE(verbose.on());
+	REQUIRE(changes == std::map<std::string, int>{ { "port", 1 }, { "verbose", 1 } });
+
+	// Unchanged input touches nothing
+	changes.clear();
+	REQUIRE(parser.reload({"service", "--port=9000", "-v"}));
+	REQUIRE(changes.empty());
+
+	// Only the changed flag is reported
+	REQUIRE(parser.reload({"service", "--port=9000", "-v", "--host=example.com"}));
+	REQUIRE(host.value == "example.com");
+	REQUIRE(changes == std::map<std::string, int>{ { "host", 1 } });
+
+	// Removed entries go back to their defaults
+	changes.clear();
+	REQUIRE(parser.reload({"service", "--host=example.com"}));
+	REQUIRE(port.value == "8080");
+	REQUIRE_FALSE(verbose.on());
+	REQUIRE_FALSE(parser.isGiven(port));
+	REQUIRE(parser.isGiven(host));
+	REQUIRE(changes == std::map<std::string, int>{ { "port", 1 }, { "verbose", 1 } });
+}
+
+TEST_CASE("Failed reload applies nothing", "[reload]")
+{
+	cmdline::Parser parser;
+	auto& port = parser.addOption("port", 'p', "8080").setRange(1, 65535);
+	auto& name = parser.addOption("name");
+
+	int calls = 0;
+	parser.onChange("name", [&calls](const cmdline::Argument&) { calls++; });
+
+	REQUIRE(parser.reload({"service", "--name=a"}));
+	REQUIRE(calls == 1);
+
+	REQUIRE_FALSE(parser.reload({"service", "--name=b", "--port=0"}));
+	REQUIRE(name.value == "a");
+	REQUIRE(port.value == "8080");
+	REQUIRE(calls == 1);
+}
+
+TEST_CASE("Reload of bound entries", "[reload]")
+{
+	int threads = 1;
+	bool verbose = false;
+
+	cmdline::Parser parser;
+	parser.addOption("threads", 'j', threads);
+	parser.addSwitch("verbose", 'v', verbose);
+	parser.addArgument("input");
+
+	int calls = 0;
+	parser.onChange("threads", [&calls](const cmdline::Argument&) { calls++; });
+
+	REQUIRE(parser.reload({"service", "in", "-j", "4", "-v"}));
+	REQUIRE(threads == 4);
+	REQUIRE(verbose);
+	REQUIRE(parser.getArgument("input")->value == "in");
+
+	REQUIRE(parser.reload({"service", "in", "-j", "4"}));
+	REQUIRE(threads == 4);
+	REQUIRE_FALSE(verbose);
+	REQUIRE(calls == 1);
+
+	REQUIRE(parser.reload({"service", "in", "-j8"}));
+	REQUIRE(threads == 8);
+	REQUIRE(calls == 2);
+}
@@ -0,0 +1,198 @@
+#include "libcmdline/schema.h"
+
+#include <catch2/catch_all.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#include <cstdio>
+#include <fstream>
+
+using namespace Catch::Matchers;
+
+namespace
+{
+	void buildSchema(cmdline::Parser& parser)
+	{
+		parser.setHelp("Schema test application");
+		parser.addHelpSection("Network", "Network settings");
+		parser.addArgument("input", "", cmdline::Req::required, "Input file");
+		parser.addArgument("output", "out.txt", cmdline::Req::optional, "Output file");
+		parser.addOption("port", 'p', "8080", cmdline::Req::optional, "Port to listen on");
+		parser.addOption("host", 'h', "", cmdline::Req::required, "Host name");
+		parser.addSwitch("verbose", 'v', "Verbose output");
+		for (int i = 0; i < 100; i++)
+			parser.addOption("generated-" + std::to_string(i));
+	}
+
+	std::shared_ptr<cmdline::SchemaBlob> loadBlob(const std::string& data)
+	{
+		auto blob = std::make_shared<cmdline::SchemaBlob>();
+		auto res = blob->load(data.data(), data.size());
+		INFO(res.errorStr());
+		REQUIRE(res);
+		return blob;
+	}
+}
+
+TEST_CASE("Schema blob lookups", "[schema]")
+{
+	cmdline::Parser parser;
+	buildSchema(parser);
+	std::string data = parser.saveSchema();
+
+	auto blob = loadBlob(data);
+	REQUIRE(blob->size() == 2 + 102 + 2); // Including the help switch
+	REQUIRE(blob->help() == "Schema test application");
+	REQUIRE(blob->sectionCount() == 1);
+	REQUIRE(blob->section(0).name == "Network");
+
+	size_t port = blob->find("port", cmdline::ArgKind::option);
+	REQUIRE(port != cmdline::SchemaBlob::npos);
+	REQUIRE(blob->find('p', cmdline::ArgKind::option) == port);
+	REQUIRE(blob->entry(port).value == "8080");
+	REQUIRE(blob->entry(port).description == "Port to listen on");
+
+	REQUIRE(blob->find("port", cmdline::ArgKind::switch_) == cmdline::SchemaBlob::npos);
+	REQUIRE(blob->find("nonexistent", cmdline::ArgKind::option) == cmdline::SchemaBlob::npos);
+	REQUIRE(blob->find("generated-99", cmdline::ArgKind::option) != cmdline::SchemaBlob::npos);
+	REQUIRE(blob->find('v', cmdline::ArgKind::switch_) == blob->find("verbose", cmdline::ArgKind::switch_));
+}
+
+TEST_CASE("Parsing with schema blob", "[schema]")
+{
+	std::string data;
+	{
+		cmdline::Parser parser;
+		buildSchema(parser);
+		data = parser.saveSchema();
+	}
+
+	cmdline::Parser parser(false);
+	parser.setSchema(loadBlob(data));
+
+	auto res = parser.parse({"appname", "in.txt", "-hlocalhost", "-v"});
+	INFO(res.errorStr());
+	REQUIRE(res);
+	REQUIRE(parser.getArgument("input")->value == "in.txt");
+	REQUIRE(parser.getArgument("output")->value == "out.txt");
+	REQUIRE(parser.getOption("host")->value == "localhost");
+	REQUIRE(parser.getOption("port")->value == "8080");
+	REQUIRE(parser.getSwitch("verbose")->on());
+
+	res = parser.parse({"appname", "in.txt", "--unknown"});
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("\"--unknown\""));
+}
+
+TEST_CASE("Schema blob required options", "[schema]")
+{
+	std::string data;
+	{
+		cmdline::Parser parser;
+		buildSchema(parser);
+		data = parser.saveSchema();
+	}
+
+	cmdline::Parser parser(false);
+	parser.setSchema(loadBlob(data));
+
+	auto res = parser.parse({"appname", "in.txt"});
+	REQUIRE_THAT(res.errorStr(), ContainsSubstring("Option host is required"));
+}
+
+TEST_CASE("Schema blob help", "[schema]")
+{
+	cmdline::Parser original;
+	buildSchema(original);
+	original.parse({"appname", "in.txt", "-hlocalhost"});
+
+	std::string data = original.saveSchema();
+	cmdline::Parser parser(false);
+	parser.setSchema(loadBlob(data));
+	parser.parse({"appname", "in.txt", "-hlocalhost", "-v"});
+	parser.getSwitch("verbose")->setValue(false);
+
+	REQUIRE(parser.getHelp() == original.getHelp());
+}
+
+TEST_CASE("Mapping schema file", "[schema]")
+{
+	cmdline::Parser original;
+	buildSchema(original);
+
+	std::string path = "libcmdline_schematest.bin";
+	{
+		std::ofstream file(path, std::ios::binary);
+		file << original.saveSchema();
+	}
+
+	auto blob = std::make_shared<cmdline::SchemaBlob>();
+	auto res = blob->open(path);
+	INFO(res.errorStr());
+	REQUIRE(res);
+
+	cmdline::Parser parser(false);
+	parser.setSchema(blob);
+	REQUIRE(parser.parse({"appname", "in.txt", "--host=abc", "--generated-42=x"}));
+	REQUIRE(parser.getOption("generated-42")->value == "x");
+
+	std::remove(path.c_str());
+}
+
+TEST_CASE("Rejecting invalid schema blobs", "[schema]")
+{
+	cmdline::Parser parser;
+	std::string data = parser.saveSchema();
+
+	cmdline::SchemaBlob blob;
+	REQUIRE_FALSE(blob.load(data.data(), data.size() - 1));
+
+	std::string garbage(64, 'x');
+	REQUIRE_THAT(blob.load(garbage.data(), garbage.size()).errorStr(), ContainsSubstring("Not a schema blob"));
+
+	REQUIRE_FALSE(blob.open("nonexistent-schema-file.bin"));
+}
+
+TEST_CASE("Descriptions stay in the schema blob", "[schema]")
+{
+	cmdline::Parser original;
+	buildSchema(original);
+	std::string data = original.saveSchema();
+
+	cmdline::Parser parser(false);
+	parser.setSchema(loadBlob(data));
+
+	const cmdline::Option* port = parser.getOption("port");
+	REQUIRE(port->description.empty());
+	REQUIRE(parser.getDescription(*port) == "Port to listen on");
+	REQUIRE(parser.getDescription(*parser.getSwitch("verbose")) == "Verbose output");
+
+	auto help = parser.getHelp();
+	REQUIRE_THAT(help, StartsWith("Schema test application"));
+	REQUIRE_THAT(help, ContainsSubstring("= Port to listen on"));
+	REQUIRE_THAT(help, ContainsSubstring("= Input file"));
+}
+
+TEST_CASE("Aliases in schema blobs", "[schema]")
+{
+	cmdline::Parser original;
+	buildSchema(original);
+	original.addAlias("port", "listen");
+	original.addAlias("port", 'P');
+	original.addAlias("verbose", "debug");
+	std::string data = original.saveSchema();
+
+	auto blob = loadBlob(data);
+	REQUIRE(blob->aliasCount() == 3);
+	REQUIRE(blob->find("listen", cmdline::ArgKind::option) == blob->find("port", cmdline::ArgKind::option));
+	REQUIRE(blob->find('P', cmdline::ArgKind::option) == blob->find("port", cmdline::ArgKind::option));
+	REQUIRE(blob->find("listen", cmdline::ArgKind::switch_) == cmdline::SchemaBlob::npos);
+
+	cmdline::Parser parser(false);
+	parser.setSchema(blob);
+
+	REQUIRE(parser.parse({"appname", "in", "--host=h", "-P", "9000", "--debug"}));
+	REQUIRE(parser.getOption("port")->value == "9000");
+	REQUIRE(parser.getOption("listen") == parser.getOption("port"));
+	REQUIRE(parser.getSwitch("verbose")->on());
+	REQUIRE(parser.getOption("port")->aliases == std::vector<std::string>{ "listen" });
+	REQUIRE_FALSE(parser.addAlias("host", "listen"));
+}
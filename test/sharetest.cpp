@@ -0,0 +1,83 @@
+#include "libcmdline/cmdline.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <memory>
+
+TEST_CASE("Copied predicates follow the copy", "[share]")
+{
+	auto original = std::make_unique<cmdline::Parser>();
+	auto& sw = original->addSwitch("advanced", 'a');
+	original->addOption("level").setPred(cmdline::enableWhenSwitchIsSet(sw));
+
+	cmdline::Parser copy(*original);
+	original->getSwitch("advanced")->setValue(true);
+	original.reset();
+
+	// Neither the original's state nor its lifetime matter to the copy
+	REQUIRE(copy.getOptions().size() == 0);
+	REQUIRE(copy.parse({"app", "--advanced", "--level=3"}));
+	REQUIRE(copy.getOption("level")->value == "3");
+	REQUIRE(copy.getOptions().size() == 1);
+}
+
+TEST_CASE("Parsers share a base", "[share]")
+{
+	auto base = std::make_shared<cmdline::Parser>();
+	base->addArgument("input");
+	auto& sw = base->addSwitch("advanced", 'a');
+	base->addOption("level", 'l', "1").setPred(cmdline::enableWhenSwitchIsSet(sw));
+	base->addOption("threads", 't', "4");
+	base->addOption("output", 'o', "out.txt");
+
+	cmdline::Parser first(base);
+	cmdline::Parser second(base);
+
+	REQUIRE(first.parse({"app", "in.txt", "-a", "--level=3"}));
+	REQUIRE(first.getArguments().size() == 1);
+	REQUIRE(first.getOption("level")->value == "3");
+	auto res = second.parse({"app", "in.txt", "-t", "8"});
+	INFO(res.errorStr());
+	REQUIRE(res);
+	REQUIRE(second.getOption("threads")->value == "8");
+
+	// Parsers are independent of each other and of the base
+	REQUIRE(first.getOption("threads")->value == "4");
+	REQUIRE(second.getOption("level")->value == "1");
+	REQUIRE(base->getOption("level")->value == "1");
+	REQUIRE(first.getSwitch('a')->on());
+	REQUIRE_FALSE(second.getSwitch("advanced")->on());
+	REQUIRE_FALSE(base->getSwitch("advanced")->on());
+
+	// Entries added to a parser stay there
+	first.addOption("extra");
+	REQUIRE(first.getOption("extra") != nullptr);
+	REQUIRE(second.getOption("extra") == nullptr);
+	REQUIRE(base->getOption("extra") == nullptr);
+
+	// Listing copies every base entry in base order
+	auto options = first.getOptions();
+	REQUIRE(options.size() == 4);
+	REQUIRE(options[0].get().name == "level");
+	REQUIRE(options[1].get().name == "threads");
+	REQUIRE(options[2].get().name == "output");
+	REQUIRE(options[3].get().name == "extra");
+}
+
+TEST_CASE("Shared base entries keep their requirements", "[share]")
+{
+	auto base = std::make_shared<cmdline::Parser>();
+	base->addOption("config", 'c', "", cmdline::Req::required);
+	base->addOption("port", 'p', "80");
+
+	cmdline::Parser parser(base);
+	REQUIRE_FALSE(parser.parse({"app", "--port=8080"}));
+	REQUIRE(parser.parse({"app", "--config=app.conf"}));
+	REQUIRE(parser.getOption("config")->value == "app.conf");
+
+	cmdline::Parser other(base);
+	REQUIRE(other.getHelp().find("--config") != std::string::npos);
+	REQUIRE(other.getHelp().find("--port") != std::string::npos);
+	other.parse({"app", "-?"});
+	REQUIRE(other.helpRequested());
+}
@@ -0,0 +1,51 @@
+#include "libcmdline/cmdline.h"
+
+#include <catch2/catch_all.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+using namespace Catch::Matchers;
+
+TEST_CASE("Recording phase stats", "[stats]")
+{
+	cmdline::Parser parser;
+	parser.addArgument("arg");
+	parser.addOption("opt", 'o');
+	parser.addSwitch("switch", 's');
+
+	parser.parse({"appname", "value", "--opt=a-value-exceeding-small-string-storage", "-s"});
+	parser.getHelp();
+
+	const auto& stats = parser.getStats();
+	if (!cmdline::InstrumentationEnabled)
+	{
+		REQUIRE(stats.tokens == 0);
+		REQUIRE(stats[cmdline::Phase::parse].calls == 0);
+		REQUIRE(stats.events.empty());
+		return;
+	}
+
+	REQUIRE(stats.tokens == 3);
+	REQUIRE(stats.lookups > 0);
+	REQUIRE(stats.predicateEvaluations > 0);
+	REQUIRE(stats[cmdline::Phase::schema].calls == 4); // Including the help switch
+	REQUIRE(stats[cmdline::Phase::parse].calls == 1);
+	REQUIRE(stats[cmdline::Phase::validate].calls >= 2);
+	REQUIRE(stats[cmdline::Phase::help].calls == 1);
+	REQUIRE(stats[cmdline::Phase::parse].allocations > 0);
+
+	parser.resetStats();
+	REQUIRE(parser.getStats().tokens == 0);
+}
+
+TEST_CASE("Chrome trace export", "[stats]")
+{
+	cmdline::Parser parser;
+	parser.parse({"appname", "--help"});
+
+	auto trace = parser.getStats().toChromeTrace();
+	REQUIRE_THAT(trace, StartsWith("{\"traceEvents\":["));
+	REQUIRE_THAT(trace, ContainsSubstring("\"parseCalls\":"));
+
+	if (cmdline::InstrumentationEnabled)
+		REQUIRE_THAT(trace, ContainsSubstring("\"name\":\"parse\""));
+}
@@ -15,3 +15,76 @@ TEST_CASE("Switch value", "[option]")
 	sw.value = "1";
 	REQUIRE(sw.on() == true);
 }
+
+TEST_CASE("Switch state in parser", "[option]")
+{
+	cmdline::Parser parser;
+	auto& sw = parser.addSwitch("feature", 'f');
+
+	REQUIRE_FALSE(sw.on());
+	REQUIRE(parser.parse({"appname", "-f"}));
+	REQUIRE(sw.on());
+	REQUIRE(sw.given());
+	REQUIRE(sw.value.empty()); // State is kept in the parser bitset
+
+	REQUIRE(parser.parse({"appname"}));
+	REQUIRE(sw.on()); // Parsing doesn't reset values if switch is not given
+	REQUIRE_FALSE(sw.given());
+}
+
+TEST_CASE("Switch negation", "[option]")
+{
+	cmdline::Parser parser;
+	auto& sw = parser.addSwitch("color");
+	sw.setValue(true);
+
+	REQUIRE(parser.parse({"appname", "--no-color"}));
+	REQUIRE_FALSE(sw.on());
+	REQUIRE(sw.given());
+
+	REQUIRE(parser.parse({"appname", "--color"}));
+	REQUIRE(sw.on());
+}
+
+TEST_CASE("Switch state snapshot", "[option]")
+{
+	cmdline::Parser parser;
+	auto& a = parser.addSwitch("a", 'a');
+	auto& b = parser.addSwitch("b", 'b');
+	parser.addSwitch("c", 'c');
+
+	REQUIRE(parser.parse({"appname", "-ab"}));
+	cmdline::ArgumentStates snapshot = parser.getStates();
+
+	REQUIRE(parser.parse({"appname", "--no-a"}));
+	REQUIRE(snapshot.on(a.id));
+	REQUIRE(snapshot.on(b.id));
+	REQUIRE_FALSE(parser.getStates().on(a.id));
+	REQUIRE(parser.getStates().getOn() != snapshot.getOn());
+}
+
+TEST_CASE("Copied parser switch state", "[option]")
+{
+	cmdline::Parser parser;
+	parser.addSwitch("x", 'x');
+
+	cmdline::Parser copy = parser;
+	REQUIRE(copy.parse({"appname", "-x"}));
+	REQUIRE(copy.getSwitch("x")->on());
+	REQUIRE_FALSE(parser.getSwitch("x")->on());
+
+	REQUIRE(copy.parse({"appname", "-?"}));
+	REQUIRE(copy.helpRequested());
+	REQUIRE_FALSE(parser.helpRequested());
+}
+
+TEST_CASE("Adding standalone switch", "[option]")
+{
+	cmdline::Switch sw("standalone");
+	sw.setValue(true);
+
+	cmdline::Parser parser;
+	auto& added = parser.addSwitch(sw);
+	REQUIRE(added.on());
+	REQUIRE(added.value.empty());
+}
@@ -0,0 +1,181 @@
+#include "libcmdline/reader.h"
+
+#include <catch2/catch_all.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+using namespace Catch::Matchers;
+
+namespace
+{
+	std::vector<std::string> tokenize(std::string_view line)
+	{
+		cmdline::LineTokenizer tokenizer;
+		REQUIRE(tokenizer.tokenize(line));
+		return { tokenizer.tokens().begin(), tokenizer.tokens().end() };
+	}
+}
+
+TEST_CASE("Tokenizing lines", "[tokenizer]")
+{
+	using V = std::vector<std::string>;
+
+	REQUIRE(tokenize("") == V{});
+	REQUIRE(tokenize("  a  b\tc ") == V{ "a", "b", "c" });
+	REQUIRE(tokenize("--opt='a b' \"c d\"") == V{ "--opt=a b", "c d" });
+	REQUIRE(tokenize("a\\ b 'x\\y' \"q\\\"q\"") == V{ "a b", "x\\y", "q\"q" });
+	REQUIRE(tokenize("'' x") == V{ "", "x" });
+	REQUIRE(tokenize("a # comment") == V{ "a" });
+	REQUIRE(tokenize("a#b") == V{ "a#b" });
+}
+
+TEST_CASE("Tokenizing malformed lines", "[tokenizer]")
+{
+	cmdline::LineTokenizer tokenizer;
+	REQUIRE_FALSE(tokenizer.tokenize("a 'b"));
+	REQUIRE_THAT(tokenizer.error(), ContainsSubstring("Unterminated single quote"));
+	REQUIRE_FALSE(tokenizer.tokenize("a \"b"));
+	REQUIRE_THAT(tokenizer.error(), ContainsSubstring("Unterminated double quote"));
+}
+
+TEST_CASE("Parsing lines", "[tokenizer]")
+{
+	cmdline::Parser parser;
+	auto& cmd = parser.addArgument("command");
+	auto& opt = parser.addOption("name", 'n');
+
+	auto res = parser.parseLine("set --name 'hello world'");
+	INFO(res.errorStr());
+	REQUIRE(res);
+	REQUIRE(cmd.value == "set");
+	REQUIRE(opt.value == "hello world");
+
+	res = parser.parseLine("get -n\"x y\"");
+	INFO(res.errorStr());
+	REQUIRE(res);
+	REQUIRE(cmd.value == "get");
+	REQUIRE(opt.value == "x y");
+
+	REQUIRE_FALSE(parser.parseLine("get 'x"));
+}
+
+TEST_CASE("Parsing lines without allocations", "[tokenizer]")
+{
+	cmdline::Parser parser;
+	auto& cmd = parser.addArgument("command");
+	parser.addOption("name", 'n');
+	parser.addSwitch("force", 'f');
+
+	// Allocations are only counted in instrumented builds
+	REQUIRE(parser.parseLine("restart --name=service-number-one -f"));
+
+	uint64_t allocs = cmdline::detail::allocationCount();
+	auto res = parser.parseLine("reload --name=service-number-two -f");
+	allocs = cmdline::detail::allocationCount() - allocs;
+
+	REQUIRE(res);
+	REQUIRE(cmd.value == "reload");
+	REQUIRE(allocs == 0);
+}
+
+TEST_CASE("Parsing NUL separated command lines", "[tokenizer]")
+{
+	cmdline::Parser parser;
+	auto& input = parser.addArgument("input", "", cmdline::Req::optional);
+	auto& level = parser.addOption("level", 'l', "1", cmdline::Req::optional);
+	auto& verbose = parser.addSwitch("verbose", 'v');
+
+	using namespace std::string_view_literals;
+	auto res = parser.parseBuffer("tool\0--level=3\0-v\0in put\0"sv);
+	INFO(res.errorStr());
+	REQUIRE(res);
+	REQUIRE(input.value == "in put");
+	REQUIRE(level.value == "3");
+	REQUIRE(verbose.on());
+
+	// Without the final NUL, and with an empty argument
+	REQUIRE(parser.parseBuffer("tool\0\0-l\0005"sv));
+	REQUIRE(input.value.empty());
+	REQUIRE(level.value == "5");
+}
+
+TEST_CASE("Scanning NUL separated command lines", "[tokenizer]")
+{
+	cmdline::Parser parser;
+	auto& input = parser.addArgument("input");
+	auto& level = parser.addOption("level", 'l', "1", cmdline::Req::optional);
+	auto& verbose = parser.addSwitch("verbose", 'v');
+
+	using namespace std::string_view_literals;
+	cmdline::CmdlineScanner scanner(parser, 4); // Small buffer to test growing
+	REQUIRE(scanner.parse("a\0-v\0-l\0002\0first\0"sv));
+	REQUIRE(level.value == "2");
+	REQUIRE(verbose.on());
+
+	// Values of the previous command line don't leak into the next one
+	REQUIRE(scanner.parse("b\0second"sv));
+	REQUIRE(input.value == "second");
+	REQUIRE(level.value == "1");
+	REQUIRE_FALSE(verbose.on());
+	REQUIRE_FALSE(scanner.parse("c\0"sv));
+	REQUIRE_FALSE(scanner.result());
+
+	std::string path = "tokenizertest_cmdline";
+	FILE* file = std::fopen(path.c_str(), "wb");
+	REQUIRE(file);
+	const char contents[] = "proc\0--level=9\0from file";
+	std::fwrite(contents, 1, sizeof(contents), file);
+	std::fclose(file);
+
+	REQUIRE(scanner.parseFile(path));
+	REQUIRE(scanner.result());
+	REQUIRE(scanner.buffer().size() == sizeof(contents));
+	REQUIRE(input.value == "from file");
+	REQUIRE(level.value == "9");
+	std::remove(path.c_str());
+
+	REQUIRE_FALSE(scanner.parseFile("tokenizertest_missing"));
+}
+
+#ifndef _WIN32
+TEST_CASE("Reading command stream", "[tokenizer]")
+{
+	int fds[2];
+	REQUIRE(pipe(fds) == 0);
+
+	std::string input = "first --name=a\n\n# comment\nsecond 'quoted arg'\n'bad\nlast";
+	REQUIRE(write(fds[1], input.data(), input.size()) == static_cast<ssize_t>(input.size()));
+	close(fds[1]);
+
+	cmdline::Parser parser;
+	auto& cmd = parser.addArgument("command");
+	parser.addArgument("extra", "", cmdline::Req::optional);
+	auto& opt = parser.addOption("name", 'n');
+
+	cmdline::CommandReader reader(parser, fds[0], 8); // Small buffer to test growing
+	cmdline::ParseResult res;
+
+	REQUIRE(reader.next(res));
+	REQUIRE(res);
+	REQUIRE(cmd.value == "first");
+	REQUIRE(opt.value == "a");
+
+	REQUIRE(reader.next(res));
+	REQUIRE(res);
+	REQUIRE(cmd.value == "second");
+	REQUIRE(reader.line() == "second 'quoted arg'");
+
+	REQUIRE(reader.next(res));
+	REQUIRE_FALSE(res);
+
+	REQUIRE(reader.next(res));
+	REQUIRE(res);
+	REQUIRE(cmd.value == "last");
+
+	REQUIRE_FALSE(reader.next(res));
+	close(fds[0]);
+}
+#endif
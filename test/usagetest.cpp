@@ -0,0 +1,124 @@
+#include "libcmdline/usage.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+namespace
+{
+	const cmdline::UsageEntry* findEntry(const std::vector<cmdline::UsageEntry>& entries, const std::string& name)
+	{
+		for (const auto& e : entries)
+		{
+			if (e.name == name)
+				return &e;
+		}
+		return nullptr;
+	}
+
+	uint32_t fnv1a(const std::string& str)
+	{
+		uint32_t h = 2166136261u;
+		for (char c : str)
+		{
+			h ^= static_cast<unsigned char>(c);
+			h *= 16777619u;
+		}
+		return h;
+	}
+}
+
+TEST_CASE("Usage counters", "[usage]")
+{
+	auto recorder = std::make_shared<cmdline::UsageRecorder>();
+
+	cmdline::Parser parser(false);
+	parser.addOption("level", 'l').setRange(0, 9);
+	parser.setUsageRecorder(recorder);
+	parser.addSwitch("verbose", 'v'); // Added after the recorder
+
+	parser.parse({"appname", "-l", "3"});
+	parser.parse({"appname", "--level=42", "-v"});
+	parser.parse({"appname", "--legacy-flag=1"});
+
+	REQUIRE(recorder->parses() == 3);
+
+	auto entries = recorder->entries();
+	const auto* level = findEntry(entries, "level");
+	REQUIRE(level);
+	REQUIRE(level->given == 2);
+	REQUIRE(level->defaulted == 1);
+	REQUIRE(level->rejected == 1);
+
+	const auto* verbose = findEntry(entries, "verbose");
+	REQUIRE(verbose);
+	REQUIRE(verbose->given == 1);
+	REQUIRE(verbose->defaulted == 2);
+
+	auto unknown = recorder->unknown();
+	REQUIRE(unknown.size() == 1);
+	REQUIRE(unknown[0].first == fnv1a("--legacy-flag"));
+	REQUIRE(unknown[0].second == 1);
+}
+
+TEST_CASE("Usage counters shared between threads", "[usage]")
+{
+	auto recorder = std::make_shared<cmdline::UsageRecorder>();
+
+	cmdline::Parser parser(false);
+	parser.addSwitch("verbose", 'v');
+	parser.setUsageRecorder(recorder);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([parser]() mutable {
+			for (int i = 0; i < 100; i++)
+				parser.parse({"appname", "-v"});
+		});
+	}
+	for (auto& t : threads)
+		t.join();
+
+	REQUIRE(recorder->parses() == 400);
+	REQUIRE(findEntry(recorder->entries(), "verbose")->given == 400);
+}
+
+TEST_CASE("Usage file flush and merge", "[usage]")
+{
+	std::string path = "usagetest.usage";
+	std::remove(path.c_str());
+
+	auto recorder = std::make_shared<cmdline::UsageRecorder>();
+	cmdline::Parser parser(false);
+	parser.addOption("name with spaces");
+	parser.addSwitch("verbose", 'v');
+	parser.setUsageRecorder(recorder);
+
+	parser.parse({"appname", "-v"});
+	REQUIRE(recorder->flush(path));
+	parser.parse({"appname", "--unknown"});
+	parser.parse({"appname", "-v"});
+	REQUIRE(recorder->flush(path));
+
+	// Flushed counters start over
+	REQUIRE(recorder->parses() == 0);
+	REQUIRE(findEntry(recorder->entries(), "verbose")->given == 0);
+
+	cmdline::UsageRecorder aggregate;
+	REQUIRE(aggregate.merge(path));
+	REQUIRE(aggregate.parses() == 3);
+
+	auto entries = aggregate.entries();
+	REQUIRE(findEntry(entries, "verbose")->given == 2);
+	REQUIRE(findEntry(entries, "verbose")->defaulted == 1);
+	REQUIRE(findEntry(entries, "name with spaces")->defaulted == 3);
+	REQUIRE(aggregate.unknown().size() == 1);
+
+	std::ofstream(path, std::ios::app) << "garbage\n";
+	REQUIRE_FALSE(cmdline::UsageRecorder().merge(path));
+
+	std::remove(path.c_str());
+}